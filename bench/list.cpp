@@ -0,0 +1,117 @@
+#include <array>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include <QtCore/QtGlobal>
+#include "kstore/list_impl.hpp"
+
+namespace
+{
+struct ListItem {
+    int uid;
+    int payload[7];
+};
+} // namespace
+
+template<>
+struct kstore::ItemTrait<ListItem> {
+    using key_type = int;
+    static auto key(kstore::param_type<ListItem> m) { return m.uid; }
+};
+
+namespace
+{
+using kstore::ListStoreType;
+using kstore::usize;
+
+// expose the protected edit api, no model around it
+template<ListStoreType S>
+struct BenchList : kstore::detail::ListImpl<ListItem, std::allocator<ListItem>, S> {
+    using base = kstore::detail::ListImpl<ListItem, std::allocator<ListItem>, S>;
+    using base::_erase_impl;
+    using base::_insert_impl;
+    using base::_move_impl;
+
+    explicit BenchList(usize n) {
+        std::vector<ListItem> items(n);
+        for (usize i = 0; i < n; i++) items[i].uid = (int)i;
+        _insert_impl(0, items);
+    }
+};
+
+template<ListStoreType S>
+void BM_ListInsertMiddle(benchmark::State& state) {
+    BenchList<S> list(state.range(0));
+    auto         mid = list.size() / 2;
+    int          key = (int)list.size();
+    for (auto _ : state) {
+        list._insert_impl(mid, std::array { ListItem { key++ } });
+        list._erase_impl(mid, mid + 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<ListStoreType S>
+void BM_ListPrepend(benchmark::State& state) {
+    int key = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BenchList<S> list(0);
+        state.ResumeTiming();
+        for (std::int64_t i = 0; i < state.range(0); i++) {
+            list._insert_impl(0, std::array { ListItem { key++ } });
+        }
+        benchmark::DoNotOptimize(list.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<ListStoreType S>
+void BM_ListMove(benchmark::State& state) {
+    BenchList<S> list(state.range(0));
+    auto         n = list.size();
+    for (auto _ : state) {
+        // front to back, the worst case for the vector
+        list._move_impl(0, n, 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<ListStoreType S>
+void BM_ListAt(benchmark::State& state) {
+    BenchList<S>       list(state.range(0));
+    std::vector<usize> rows(1024);
+    std::mt19937       rng { 42 };
+    for (auto& r : rows) r = rng() % list.size();
+    usize i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.at(rows[i]));
+        i = (i + 1) % rows.size();
+    }
+}
+
+template<ListStoreType S>
+void BM_ListQueryIdx(benchmark::State& state) {
+    BenchList<S>     list(state.range(0));
+    std::vector<int> keys(1024);
+    std::mt19937     rng { 42 };
+    for (auto& k : keys) k = (int)(rng() % list.size());
+    usize i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.query_idx(keys[i]));
+        i = (i + 1) % keys.size();
+    }
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ListInsertMiddle, ListStoreType::VectorWithMap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListInsertMiddle, ListStoreType::Tree)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListPrepend, ListStoreType::VectorWithMap)->Range(1 << 8, 1 << 14);
+BENCHMARK_TEMPLATE(BM_ListPrepend, ListStoreType::Tree)->Range(1 << 8, 1 << 14);
+BENCHMARK_TEMPLATE(BM_ListMove, ListStoreType::VectorWithMap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListMove, ListStoreType::Tree)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListAt, ListStoreType::VectorWithMap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListAt, ListStoreType::Tree)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListQueryIdx, ListStoreType::VectorWithMap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ListQueryIdx, ListStoreType::Tree)->Range(1 << 10, 1 << 18);
@@ -0,0 +1,106 @@
+#include <array>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "kstore/qt/gadget_model.hpp"
+
+struct RowItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(QString title MEMBER title)
+    Q_PROPERTY(QString subtitle MEMBER subtitle)
+    Q_PROPERTY(QString author MEMBER author)
+    Q_PROPERTY(QString cover MEMBER cover)
+    Q_PROPERTY(double score MEMBER score)
+    Q_PROPERTY(double progress MEMBER progress)
+    Q_PROPERTY(qint64 created MEMBER created)
+    Q_PROPERTY(qint64 updated MEMBER updated)
+    Q_PROPERTY(int count MEMBER count)
+    Q_PROPERTY(bool pinned MEMBER pinned)
+    Q_PROPERTY(bool read MEMBER read)
+public:
+    int     uid { 0 };
+    QString title;
+    QString subtitle;
+    QString author;
+    QString cover;
+    double  score { 0 };
+    double  progress { 0 };
+    qint64  created { 0 };
+    qint64  updated { 0 };
+    int     count { 0 };
+    bool    pinned { false };
+    bool    read { false };
+};
+
+template<>
+struct kstore::ItemTrait<RowItem> {
+    using key_type = int;
+    static auto key(kstore::param_type<RowItem> m) { return m.uid; }
+};
+
+struct RowModel : kstore::QGadgetListModel,
+                  kstore::QMetaListModelCRTP<RowItem, RowModel, kstore::ListStoreType::Vector> {
+    Q_OBJECT
+public:
+    RowModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+namespace
+{
+constexpr int role_count = 12;
+
+void fill(RowModel& model, std::int64_t n) {
+    std::vector<RowItem> items(n);
+    for (int i = 0; i < (int)n; i++) {
+        items[i].uid   = i;
+        items[i].title = QStringLiteral("title of row %1").arg(i);
+        items[i].score = i * 0.5;
+    }
+    model.resetModel(items);
+}
+
+// what a delegate binding every property costs through data()
+void BM_RowData(benchmark::State& state) {
+    RowModel model;
+    fill(model, state.range(0));
+    const int rows = model.rowCount();
+    int       row  = 0;
+    for (auto _ : state) {
+        auto index = model.index(row);
+        for (int r = 0; r < role_count; r++) {
+            benchmark::DoNotOptimize(model.data(index, Qt::UserRole + 1 + r));
+        }
+        row = (row + 1) % rows;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RowMultiData(benchmark::State& state) {
+    RowModel model;
+    fill(model, state.range(0));
+    const int rows = model.rowCount();
+    int       row  = 0;
+
+    std::array<QModelRoleData, role_count> roles {
+        QModelRoleData(Qt::UserRole + 1),  QModelRoleData(Qt::UserRole + 2),
+        QModelRoleData(Qt::UserRole + 3),  QModelRoleData(Qt::UserRole + 4),
+        QModelRoleData(Qt::UserRole + 5),  QModelRoleData(Qt::UserRole + 6),
+        QModelRoleData(Qt::UserRole + 7),  QModelRoleData(Qt::UserRole + 8),
+        QModelRoleData(Qt::UserRole + 9),  QModelRoleData(Qt::UserRole + 10),
+        QModelRoleData(Qt::UserRole + 11), QModelRoleData(Qt::UserRole + 12)
+    };
+    for (auto _ : state) {
+        model.multiData(model.index(row), roles);
+        benchmark::DoNotOptimize(roles.data());
+        row = (row + 1) % rows;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+} // namespace
+
+BENCHMARK(BM_RowData)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_RowMultiData)->Arg(1 << 10)->Arg(1 << 16);
+
+#include "model_data.moc"
@@ -0,0 +1,55 @@
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "kstore/arc.hpp"
+#include "kstore/rc.hpp"
+
+namespace
+{
+struct Payload {
+    int value[8];
+};
+
+template<typename P>
+auto make_ptr() -> P {
+    if constexpr (std::same_as<P, kstore::Arc<Payload>>) {
+        return P::make();
+    } else {
+        return P::create(new Payload {});
+    }
+}
+
+template<typename P>
+void BM_PtrCopy(benchmark::State& state) {
+    auto p = make_ptr<P>();
+    for (auto _ : state) {
+        P c(p);
+        benchmark::DoNotOptimize(c);
+    }
+}
+
+template<typename P>
+void BM_PtrMove(benchmark::State& state) {
+    auto p = make_ptr<P>();
+    for (auto _ : state) {
+        P c(std::move(p));
+        benchmark::DoNotOptimize(c);
+        p = std::move(c);
+    }
+}
+
+template<typename P>
+void BM_PtrCreateDestroy(benchmark::State& state) {
+    for (auto _ : state) {
+        auto p = make_ptr<P>();
+        benchmark::DoNotOptimize(p);
+    }
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_PtrCopy, kstore::Rc<Payload>);
+BENCHMARK_TEMPLATE(BM_PtrCopy, kstore::Arc<Payload>);
+BENCHMARK_TEMPLATE(BM_PtrMove, kstore::Rc<Payload>);
+BENCHMARK_TEMPLATE(BM_PtrMove, kstore::Arc<Payload>);
+BENCHMARK_TEMPLATE(BM_PtrCreateDestroy, kstore::Rc<Payload>);
+BENCHMARK_TEMPLATE(BM_PtrCreateDestroy, kstore::Arc<Payload>);
@@ -0,0 +1,116 @@
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QTemporaryDir>
+#include "kstore/qt/meta_utils.hpp"
+#include "kstore/qt/snapshot.hpp"
+
+struct SnapItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(QString title MEMBER title)
+    Q_PROPERTY(QString author MEMBER author)
+    Q_PROPERTY(double score MEMBER score)
+    Q_PROPERTY(qint64 created MEMBER created)
+    Q_PROPERTY(bool pinned MEMBER pinned)
+public:
+    int     uid { 0 };
+    QString title;
+    QString author;
+    double  score { 0 };
+    qint64  created { 0 };
+    bool    pinned { false };
+};
+
+template<>
+struct kstore::ItemTrait<SnapItem> {
+    using key_type   = int;
+    using store_type = kstore::ShareStore<SnapItem>;
+    static auto key(kstore::param_type<SnapItem> m) { return m.uid; }
+};
+
+namespace
+{
+using Snapshot = kstore::QStoreSnapshot<SnapItem>;
+
+auto make_items(std::int64_t n) -> std::vector<SnapItem> {
+    std::vector<SnapItem> out;
+    out.reserve(n);
+    for (int i = 0; i < n; i++) {
+        out.push_back(SnapItem { i,
+                                 QStringLiteral("title of item %1").arg(i),
+                                 QStringLiteral("author %1").arg(i % 97),
+                                 i * 0.5,
+                                 1700000000000 + i,
+                                 i % 7 == 0 });
+    }
+    return out;
+}
+
+// the cached list as it is reloaded today
+void BM_RestoreJson(benchmark::State& state) {
+    QJsonArray arr;
+    for (auto& item : make_items(state.range(0))) {
+        arr.append(kstore::qvariant_to_josn(QVariant::fromValue(item)));
+    }
+    auto bytes = QJsonDocument(arr).toJson(QJsonDocument::Compact);
+
+    for (auto _ : state) {
+        kstore::ShareStore<SnapItem> store;
+        std::vector<SnapItem>        items;
+        auto                         doc = QJsonDocument::fromJson(bytes);
+        for (const auto& v : doc.array()) {
+            if (auto item = kstore::qvariant_from_josn<SnapItem>(v)) items.push_back(*item);
+        }
+        store.store_insert_range(items);
+        benchmark::DoNotOptimize(store.size());
+    }
+}
+
+void BM_RestoreSnapshot(benchmark::State& state) {
+    QTemporaryDir dir;
+    auto          path = dir.filePath("bench.snap");
+    {
+        kstore::ShareStore<SnapItem> store;
+        Snapshot::List               list { "main", {} };
+        for (auto& item : make_items(state.range(0))) {
+            store.store_insert(item);
+            list.keys.push_back(item.uid);
+        }
+        Snapshot::write(path, store, std::span { &list, 1 });
+    }
+
+    for (auto _ : state) {
+        kstore::ShareStore<SnapItem> store;
+        Snapshot                     snap;
+        snap.open(path);
+        store.store_insert_range(snap.items("main"));
+        benchmark::DoNotOptimize(store.size());
+    }
+}
+
+// startup cost before any item is decoded
+void BM_OpenSnapshot(benchmark::State& state) {
+    QTemporaryDir dir;
+    auto          path = dir.filePath("bench.snap");
+    {
+        kstore::ShareStore<SnapItem> store;
+        for (auto& item : make_items(state.range(0))) store.store_insert(item);
+        Snapshot::write(path, store);
+    }
+
+    for (auto _ : state) {
+        Snapshot snap;
+        snap.open(path);
+        benchmark::DoNotOptimize(snap.size());
+    }
+}
+} // namespace
+
+BENCHMARK(BM_RestoreJson)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_RestoreSnapshot)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_OpenSnapshot)->Range(1 << 10, 1 << 16);
+
+#include "snapshot.moc"
@@ -0,0 +1,88 @@
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include <QtCore/QtGlobal>
+#include "kstore/share_store.hpp"
+
+struct BenchItem {
+    int uid;
+    int payload[7];
+};
+
+template<>
+struct kstore::ItemTrait<BenchItem> {
+    using key_type = int;
+    static auto key(kstore::param_type<BenchItem> m) { return m.uid; }
+};
+
+namespace
+{
+using kstore::usize;
+
+template<kstore::StoreMapType M>
+using BenchStore = kstore::ShareStore<BenchItem, std::allocator<BenchItem>, void, std::int64_t, M>;
+
+auto shuffled_keys(std::int64_t n, unsigned seed = 42) -> std::vector<int> {
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; i++) keys[i] = i * 7 + 1;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937 { seed });
+    return keys;
+}
+
+template<kstore::StoreMapType M>
+void fill(BenchStore<M>& store, const std::vector<int>& keys) {
+    for (auto k : keys) {
+        // the returned StoreItem drops its ref, one ref is left for the store
+        store.store_insert(BenchItem { k });
+    }
+}
+
+template<kstore::StoreMapType M>
+void BM_StoreQuery(benchmark::State& state) {
+    BenchStore<M> store;
+    fill(store, shuffled_keys(state.range(0)));
+
+    // query in a different order than insertion, node allocations are otherwise sequential
+    auto  keys = shuffled_keys(state.range(0), 7);
+    usize i    = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.store_query(keys[i]));
+        if (++i == keys.size()) i = 0;
+    }
+}
+
+template<kstore::StoreMapType M>
+void BM_StoreInsert(benchmark::State& state) {
+    auto          keys = shuffled_keys(state.range(0));
+    BenchStore<M> store;
+    for (auto _ : state) {
+        fill(store, keys);
+        state.PauseTiming();
+        for (auto k : keys) store.store_remove(k);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template<kstore::StoreMapType M>
+void BM_StoreErase(benchmark::State& state) {
+    auto          keys = shuffled_keys(state.range(0));
+    BenchStore<M> store;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill(store, keys);
+        state.ResumeTiming();
+        for (auto k : keys) store.store_remove(k);
+        benchmark::DoNotOptimize(store.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_StoreQuery, kstore::StoreMapType::Node)->Range(1 << 10, 1 << 19);
+BENCHMARK_TEMPLATE(BM_StoreQuery, kstore::StoreMapType::Flat)->Range(1 << 10, 1 << 19);
+BENCHMARK_TEMPLATE(BM_StoreInsert, kstore::StoreMapType::Node)->Range(1 << 10, 1 << 19);
+BENCHMARK_TEMPLATE(BM_StoreInsert, kstore::StoreMapType::Flat)->Range(1 << 10, 1 << 19);
+BENCHMARK_TEMPLATE(BM_StoreErase, kstore::StoreMapType::Node)->Range(1 << 10, 1 << 19);
+BENCHMARK_TEMPLATE(BM_StoreErase, kstore::StoreMapType::Flat)->Range(1 << 10, 1 << 19);
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace kstore
+{
+
+template<typename T>
+class Weak;
+
+namespace detail
+{
+template<typename T>
+struct ArcInner {
+    template<typename... Args>
+    ArcInner(Args&&... args): strong(1), weak(1) {
+        new (storage) T(std::forward<Args>(args)...);
+    }
+
+    auto value() noexcept -> T* { return std::launder(reinterpret_cast<T*>(storage)); }
+
+    // weak holds one extra count on behalf of all strong refs
+    std::atomic<std::size_t> strong;
+    std::atomic<std::size_t> weak;
+    alignas(T) std::byte storage[sizeof(T)];
+};
+} // namespace detail
+
+///
+/// @brief Atomically reference counted pointer
+/// @details
+/// The counts live in the same allocation as T, created by Arc::make.
+/// Copies may be shared across threads, T itself is not synchronized.
+template<typename T>
+class Arc {
+public:
+    Arc() noexcept: m_inner(nullptr) {}
+    ~Arc() { release(); }
+
+    Arc(const Arc& o) noexcept: m_inner(o.m_inner) {
+        if (m_inner) m_inner->strong.fetch_add(1, std::memory_order_relaxed);
+    }
+    Arc(Arc&& o) noexcept: m_inner(std::exchange(o.m_inner, nullptr)) {}
+    Arc& operator=(const Arc& o) noexcept {
+        Arc(o).swap(*this);
+        return *this;
+    }
+    Arc& operator=(Arc&& o) noexcept {
+        Arc(std::move(o)).swap(*this);
+        return *this;
+    }
+
+    template<typename... Args>
+    static auto make(Args&&... args) -> Arc {
+        Arc arc;
+        arc.m_inner = new detail::ArcInner<T>(std::forward<Args>(args)...);
+        return arc;
+    }
+
+    void swap(Arc& o) noexcept { std::swap(m_inner, o.m_inner); }
+
+    auto downgrade() const noexcept -> Weak<T>;
+    auto use_count() const noexcept -> std::size_t {
+        return m_inner ? m_inner->strong.load(std::memory_order_relaxed) : 0;
+    }
+
+    auto           get() const noexcept -> T* { return m_inner ? m_inner->value() : nullptr; }
+    operator bool() const noexcept { return m_inner != nullptr; }
+    T*             operator->() const noexcept { return m_inner->value(); }
+    T&             operator*() const noexcept { return *m_inner->value(); }
+    constexpr bool operator==(const Arc& o) const { return m_inner == o.m_inner; }
+
+private:
+    friend class Weak<T>;
+    explicit Arc(detail::ArcInner<T>* inner) noexcept: m_inner(inner) {}
+
+    void release() noexcept {
+        if (! m_inner) return;
+        if (m_inner->strong.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_inner->value()->~T();
+            if (m_inner->weak.fetch_sub(1, std::memory_order_acq_rel) == 1) delete m_inner;
+        }
+        m_inner = nullptr;
+    }
+
+    detail::ArcInner<T>* m_inner;
+};
+
+///
+/// @brief Non-owning companion of Arc
+/// @details Keeps the allocation alive but not T, use lock() to get an Arc back.
+template<typename T>
+class Weak {
+public:
+    Weak() noexcept: m_inner(nullptr) {}
+    ~Weak() { release(); }
+
+    Weak(const Weak& o) noexcept: m_inner(o.m_inner) {
+        if (m_inner) m_inner->weak.fetch_add(1, std::memory_order_relaxed);
+    }
+    Weak(Weak&& o) noexcept: m_inner(std::exchange(o.m_inner, nullptr)) {}
+    Weak& operator=(const Weak& o) noexcept {
+        Weak(o).swap(*this);
+        return *this;
+    }
+    Weak& operator=(Weak&& o) noexcept {
+        Weak(std::move(o)).swap(*this);
+        return *this;
+    }
+
+    void swap(Weak& o) noexcept { std::swap(m_inner, o.m_inner); }
+
+    auto lock() const noexcept -> Arc<T> {
+        if (! m_inner) return {};
+        auto count = m_inner->strong.load(std::memory_order_relaxed);
+        do {
+            if (count == 0) return {};
+        } while (! m_inner->strong.compare_exchange_weak(
+            count, count + 1, std::memory_order_acquire, std::memory_order_relaxed));
+        return Arc<T> { m_inner };
+    }
+    bool expired() const noexcept {
+        return ! m_inner || m_inner->strong.load(std::memory_order_acquire) == 0;
+    }
+
+    constexpr bool operator==(const Weak& o) const { return m_inner == o.m_inner; }
+
+private:
+    friend class Arc<T>;
+    explicit Weak(detail::ArcInner<T>* inner) noexcept: m_inner(inner) {
+        if (m_inner) m_inner->weak.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (m_inner && m_inner->weak.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete m_inner;
+        }
+        m_inner = nullptr;
+    }
+
+    detail::ArcInner<T>* m_inner;
+};
+
+template<typename T>
+auto Arc<T>::downgrade() const noexcept -> Weak<T> {
+    return Weak<T> { m_inner };
+}
+
+} // namespace kstore
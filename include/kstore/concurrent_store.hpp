@@ -0,0 +1,322 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "kstore/share_store.hpp"
+
+namespace kstore
+{
+
+///
+/// @brief ShareStore variant that is safe to use from any thread
+/// @details
+/// The key space is split into Shards buckets, each guarded by its own reader-writer lock,
+/// so producers on different threads rarely contend. Each shard maps keys to indices in its
+/// own SlotArena, as ShareStore does. Each item is an immutable shared snapshot: an update
+/// swaps in a new one, so store_query and store_at hand out a snapshot that stays valid and
+/// unchanged while it is held.
+/// Slot indices are shard local index * Shards + shard.
+///
+/// Callbacks may be registered with an executor. Notifications for that subscriber are
+/// handed to the executor, which is expected to run them on the subscriber's thread.
+template<typename T, usize Shards, typename Allocator>
+struct ConcurrentShareStore {
+    static_assert(Shards > 0);
+
+    using handle_type     = std::int64_t;
+    using key_type        = typename ItemTrait<T>::key_type;
+    using callback_type =
+        std::function<void(std::span<const key_type>, std::span<const change_mask>)>;
+    using executor_type   = std::function<void(std::function<void()>)>;
+    using store_item_type = StoreItem<T, ConcurrentShareStore>;
+    using item_type       = T;
+    using snapshot_type   = std::shared_ptr<const T>;
+
+    template<typename U>
+    using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    template<typename, typename>
+    friend class StoreItem;
+
+    struct _Item {
+        _Item(snapshot_type item, handle_type count): item(std::move(item)), count(count) {}
+
+        snapshot_type item;
+        handle_type   count;
+        auto        increase() noexcept { return ++count; }
+        auto        decrease() noexcept { return --count; }
+    };
+
+    struct Shard {
+        Shard(Allocator alloc): map(alloc), slots(alloc) {}
+
+        mutable std::shared_mutex mutex;
+        // key -> index in slots
+        std::unordered_map<key_type, std::uint32_t, std::hash<key_type>, std::equal_to<key_type>,
+                           rebind_alloc<std::pair<const key_type, std::uint32_t>>>
+                                            map;
+        detail::SlotArena<_Item, Allocator> slots;
+    };
+
+    struct Subscriber {
+        callback_type callback;
+        executor_type executor;
+    };
+
+    struct Inner {
+        Inner(Allocator alloc)
+            : shards([&alloc]<usize... I>(std::index_sequence<I...>) {
+                  return std::array<Shard, Shards> { ((void)I, Shard(alloc))... };
+              }(std::make_index_sequence<Shards> {})),
+              callbacks(alloc),
+              serial(0) {}
+
+        std::array<Shard, Shards> shards;
+
+        std::mutex callback_mutex;
+        std::map<handle_type, Subscriber, std::less<>,
+                 rebind_alloc<std::pair<const handle_type, Subscriber>>>
+                                 callbacks;
+        std::atomic<handle_type> serial;
+    };
+
+    Arc<Inner> inner;
+
+    ConcurrentShareStore(Allocator alloc = Allocator {}): inner(Arc<Inner>::make(alloc)) {}
+
+    constexpr bool operator==(const ConcurrentShareStore& o) const { return inner == o.inner; }
+
+    Allocator get_allocator() { return inner->callbacks.get_allocator(); }
+
+    auto store_query(param_type<key_type> k) const -> snapshot_type {
+        auto&            shard = shard_of(k);
+        std::shared_lock lock(shard.mutex);
+        if (auto it = shard.map.find(k); it != shard.map.end()) {
+            return shard.slots[it->second].item;
+        }
+        return nullptr;
+    }
+
+    auto store_slot(param_type<key_type> k) const -> std::optional<StoreSlot> {
+        auto             i     = shard_index(k);
+        auto&            shard = inner->shards[i];
+        std::shared_lock lock(shard.mutex);
+        if (auto it = shard.map.find(k); it != shard.map.end()) {
+            return global_slot(i, shard.slots.handle(it->second));
+        }
+        return std::nullopt;
+    }
+
+    auto store_at(StoreSlot slot) const -> snapshot_type {
+        auto&            shard = inner->shards[slot.index % Shards];
+        std::shared_lock lock(shard.mutex);
+        const auto       local = static_cast<std::uint32_t>(slot.index / Shards);
+        if (auto e = shard.slots.get({ local, slot.generation })) {
+            return e->item;
+        }
+        return nullptr;
+    }
+
+    auto store_get(param_type<key_type> k) const -> std::optional<T> {
+        if (auto snapshot = store_query(k)) return *snapshot;
+        return std::nullopt;
+    }
+
+    template<typename Range, std::ranges::range MaskRange>
+    void store_changed_callback(const Range& range, const MaskRange& masks,
+                                std::int64_t ignore_handle = 0) {
+        std::vector<Subscriber> subscribers;
+        {
+            std::lock_guard lock(inner->callback_mutex);
+            subscribers.reserve(inner->callbacks.size());
+            for (auto& el : inner->callbacks) {
+                if (el.first == ignore_handle) continue;
+                subscribers.push_back(el.second);
+            }
+        }
+        if (subscribers.empty()) return;
+
+        std::shared_ptr<const std::vector<key_type>>    keys;
+        std::shared_ptr<const std::vector<change_mask>> key_masks;
+        for (auto& sub : subscribers) {
+            if (! sub.executor) {
+                sub.callback(range, masks);
+                continue;
+            }
+            // keys must outlive this call for queued delivery
+            if (! keys) {
+                keys = std::make_shared<const std::vector<key_type>>(std::ranges::begin(range),
+                                                                     std::ranges::end(range));
+                key_masks = std::make_shared<const std::vector<change_mask>>(
+                    std::ranges::begin(masks), std::ranges::end(masks));
+            }
+            sub.executor([cb = std::move(sub.callback), keys, key_masks] {
+                cb(*keys, *key_masks);
+            });
+        }
+    }
+
+    template<typename Range>
+    void store_changed_callback(const Range& range, std::int64_t ignore_handle = 0) {
+        std::vector<change_mask, rebind_alloc<change_mask>> masks(
+            std::ranges::size(range), change_mask_all, get_allocator());
+        store_changed_callback(range, masks, ignore_handle);
+    }
+
+    auto store_insert(param_type<T> item) -> std::pair<store_item_type, bool> {
+        bool      changed { false };
+        auto      key      = ItemTrait<T>::key(item);
+        auto      i        = shard_index(key);
+        auto&     shard    = inner->shards[i];
+        auto      snapshot = make_snapshot(item);
+        StoreSlot slot;
+        {
+            std::unique_lock lock(shard.mutex);
+            auto [it, inserted] = shard.map.try_emplace(key, 0);
+            if (inserted) {
+                // same as ShareStore, the store keeps one reference of its own
+                it->second = shard.slots.emplace(std::move(snapshot), 2).index;
+            } else {
+                auto& e = shard.slots[it->second];
+                changed = item_diff<T>(*e.item, item) != 0;
+                // the old snapshot is released after the lock
+                e.item.swap(snapshot);
+                // for store item
+                e.increase();
+            }
+            slot = global_slot(i, shard.slots.handle(it->second));
+        }
+        return { { *this, key, slot }, changed };
+    }
+
+    template<std::ranges::input_range R, typename RefsOf>
+        requires std::invocable<RefsOf&, param_type<key_type>, StoreSlot>
+    auto store_upsert_many(R&& items, RefsOf&& refs_of, handle_type ignore_handle = 0)
+        -> std::vector<UpsertResult, rebind_alloc<UpsertResult>> {
+        std::vector<UpsertResult, rebind_alloc<UpsertResult>> results(get_allocator());
+        std::vector<key_type, rebind_alloc<key_type>>         updated(get_allocator());
+        std::vector<change_mask, rebind_alloc<change_mask>>   masks(get_allocator());
+        if constexpr (std::ranges::sized_range<R>) {
+            results.reserve(std::ranges::size(items));
+        }
+
+        for (auto&& el : std::forward<R>(items)) {
+            auto             key      = ItemTrait<T>::key(el);
+            auto             i        = shard_index(key);
+            auto&            shard    = inner->shards[i];
+            auto             snapshot = make_snapshot(std::forward<decltype(el)>(el));
+            std::unique_lock lock(shard.mutex);
+            auto [it, inserted] = shard.map.try_emplace(key, 0);
+            if (inserted) {
+                it->second = shard.slots.emplace(std::move(snapshot), 1).index;
+                results.push_back(UpsertResult::Inserted);
+            } else {
+                auto& e    = shard.slots[it->second];
+                auto  mask = item_diff<T>(*e.item, *snapshot);
+                e.item.swap(snapshot);
+                results.push_back(mask != 0 ? UpsertResult::Updated : UpsertResult::Unchanged);
+                updated.push_back(key);
+                masks.push_back(mask);
+            }
+            // refs_of runs under the shard lock, it must not call back into the store
+            auto slot = global_slot(i, shard.slots.handle(it->second));
+            shard.slots[it->second].count += static_cast<handle_type>(refs_of(key, slot));
+        }
+
+        if (! updated.empty()) store_changed_callback(updated, masks, ignore_handle);
+        return results;
+    }
+
+    template<std::ranges::input_range R>
+    auto store_insert_range(R&& items, handle_type ignore_handle = 0) {
+        return store_upsert_many(
+            std::forward<R>(items),
+            [](param_type<key_type>, StoreSlot) -> handle_type {
+                return 1;
+            },
+            ignore_handle);
+    }
+
+    auto store_item(param_type<key_type> k) -> std::optional<store_item_type> {
+        auto      i     = shard_index(k);
+        auto&     shard = inner->shards[i];
+        StoreSlot slot;
+        {
+            std::unique_lock lock(shard.mutex);
+            auto             it = shard.map.find(k);
+            if (it == shard.map.end()) return std::nullopt;
+            shard.slots[it->second].increase();
+            slot = global_slot(i, shard.slots.handle(it->second));
+        }
+        return store_item_type { *this, k, slot };
+    }
+
+    void store_increase(param_type<key_type> k) {
+        auto&            shard = shard_of(k);
+        std::unique_lock lock(shard.mutex);
+        if (auto it = shard.map.find(k); it != shard.map.end()) {
+            shard.slots[it->second].increase();
+        }
+    }
+
+    void store_remove(param_type<key_type> k) {
+        auto&            shard = shard_of(k);
+        std::unique_lock lock(shard.mutex);
+        if (auto it = shard.map.find(k); it != shard.map.end()) {
+            auto idx = it->second;
+            if (shard.slots[idx].decrease() == 0) {
+                shard.map.erase(it);
+                shard.slots.erase(idx);
+            }
+        }
+    }
+
+    auto store_reg_notify(callback_type cb, executor_type executor = {}) -> handle_type {
+        auto            handle = ++(inner->serial);
+        std::lock_guard lock(inner->callback_mutex);
+        inner->callbacks.insert({ handle, Subscriber { std::move(cb), std::move(executor) } });
+        return handle;
+    }
+    template<typename F>
+        requires std::invocable<F&, std::span<const key_type>>
+    auto store_reg_notify(F cb, executor_type executor = {}) -> handle_type {
+        return store_reg_notify(callback_type {
+                                    [cb = std::move(cb)](std::span<const key_type> keys,
+                                                         std::span<const change_mask>) mutable {
+                                        cb(keys);
+                                    } },
+                                std::move(executor));
+    }
+    void store_unreg_notify(handle_type handle) {
+        std::lock_guard lock(inner->callback_mutex);
+        inner->callbacks.erase(handle);
+    }
+
+    auto size() const -> std::size_t {
+        std::size_t out = 0;
+        for (auto& shard : inner->shards) {
+            std::shared_lock lock(shard.mutex);
+            out += shard.map.size();
+        }
+        return out;
+    }
+
+private:
+    auto shard_index(param_type<key_type> k) const -> usize {
+        return detail::hash_mix(std::hash<key_type> {}(k)) % Shards;
+    }
+    auto shard_of(param_type<key_type> k) const -> Shard& { return inner->shards[shard_index(k)]; }
+    template<typename U>
+    auto make_snapshot(U&& item) -> snapshot_type {
+        // not const, a list may copy it on write once it is the only holder
+        return std::allocate_shared<T>(rebind_alloc<T>(get_allocator()), std::forward<U>(item));
+    }
+    static auto global_slot(usize shard, StoreSlot local) -> StoreSlot {
+        return { static_cast<std::uint32_t>(local.index * Shards + shard), local.generation };
+    }
+};
+
+} // namespace kstore
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "kstore/item_trait.hpp"
+
+namespace kstore
+{
+
+namespace detail
+{
+using ctrl_t = std::int8_t;
+
+inline constexpr ctrl_t ctrl_empty   = -128; // 0b10000000
+inline constexpr ctrl_t ctrl_deleted = -2;   // 0b11111110
+
+constexpr auto hash_mix(usize h) noexcept -> usize {
+    // fold the high bits down so identity hashes (std::hash<int>) still spread over h1/h2
+    constexpr std::uint64_t k = 0x9E3779B97F4A7C15ull;
+    auto                    x = static_cast<std::uint64_t>(h) * k;
+    return static_cast<usize>(x ^ (x >> 32));
+}
+
+constexpr auto hash_h1(usize h) noexcept -> usize { return h >> 7; }
+constexpr auto hash_h2(usize h) noexcept -> ctrl_t { return static_cast<ctrl_t>(h & 0x7f); }
+
+///
+/// @brief Portable 8-wide control group (SWAR)
+struct CtrlGroup {
+    static constexpr usize         width = 8;
+    static constexpr std::uint64_t lsbs  = 0x0101010101010101ull;
+    static constexpr std::uint64_t msbs  = 0x8080808080808080ull;
+
+    explicit CtrlGroup(const ctrl_t* p) noexcept {
+        std::memcpy(&ctrl, p, sizeof(ctrl));
+        if constexpr (std::endian::native == std::endian::big) {
+            std::uint64_t v = 0;
+            for (usize i = 0; i < width; i++) {
+                v |= ((ctrl >> (8 * i)) & 0xff) << (8 * (width - 1 - i));
+            }
+            ctrl = v;
+        }
+    }
+
+    // may report false positives, callers always compare keys
+    auto match(ctrl_t h2) const noexcept -> std::uint64_t {
+        auto x = ctrl ^ (lsbs * static_cast<std::uint8_t>(h2));
+        return (x - lsbs) & ~x & msbs;
+    }
+    auto match_empty() const noexcept -> std::uint64_t { return ctrl & (~ctrl << 6) & msbs; }
+    auto match_empty_or_deleted() const noexcept -> std::uint64_t {
+        return ctrl & ~(ctrl << 7) & msbs;
+    }
+
+    static auto lowest(std::uint64_t mask) noexcept -> usize {
+        return static_cast<usize>(std::countr_zero(mask)) / 8;
+    }
+    static auto next(std::uint64_t mask) noexcept -> std::uint64_t { return mask & (mask - 1); }
+
+    std::uint64_t ctrl;
+};
+} // namespace detail
+
+///
+/// @brief Open-addressing hash map with SwissTable-style control bytes
+/// @details
+/// Items live in a dense slot array, so lookups touch one control group and one slot.
+/// Unlike std::unordered_map, pointers and iterators are invalidated by any insertion
+/// that grows the table.
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Allocator = std::allocator<std::pair<const K, V>>>
+class FlatHashMap {
+public:
+    using key_type        = K;
+    using mapped_type     = V;
+    using value_type      = std::pair<const K, V>;
+    using size_type       = usize;
+    using hasher          = Hash;
+    using key_equal       = KeyEqual;
+    using allocator_type  = Allocator;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+
+private:
+    using ctrl_t       = detail::ctrl_t;
+    using group_type   = detail::CtrlGroup;
+    using slot_alloc   = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    using ctrl_alloc   = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+    using slot_traits  = std::allocator_traits<slot_alloc>;
+    using ctrl_traits  = std::allocator_traits<ctrl_alloc>;
+    static constexpr usize min_capacity = group_type::width;
+
+    template<bool Const>
+    class Iter {
+        using map_ptr = std::conditional_t<Const, const FlatHashMap*, FlatHashMap*>;
+        friend class FlatHashMap;
+
+        Iter(map_ptr m, usize i) noexcept: m_map(m), m_idx(i) { skip(); }
+
+        void skip() noexcept {
+            while (m_idx < m_map->m_capacity && m_map->m_ctrl[m_idx] < 0) ++m_idx;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = FlatHashMap::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer           = std::conditional_t<Const, const value_type*, value_type*>;
+
+        Iter() noexcept: m_map(nullptr), m_idx(0) {}
+        template<bool C>
+            requires(Const && ! C)
+        Iter(const Iter<C>& o) noexcept: m_map(o.m_map), m_idx(o.m_idx) {}
+
+        auto operator*() const noexcept -> reference { return m_map->m_slots[m_idx]; }
+        auto operator->() const noexcept -> pointer { return m_map->m_slots + m_idx; }
+        auto operator++() noexcept -> Iter& {
+            ++m_idx;
+            skip();
+            return *this;
+        }
+        auto operator++(int) noexcept -> Iter {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        bool operator==(const Iter& o) const noexcept { return m_idx == o.m_idx; }
+
+    private:
+        template<bool>
+        friend class Iter;
+
+        map_ptr m_map;
+        usize   m_idx;
+    };
+
+public:
+    using iterator       = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    FlatHashMap(Allocator alloc = Allocator {})
+        : m_slot_alloc(alloc),
+          m_ctrl_alloc(alloc),
+          m_ctrl(nullptr),
+          m_slots(nullptr),
+          m_capacity(0),
+          m_size(0),
+          m_growth_left(0) {}
+
+    FlatHashMap(const FlatHashMap& o)
+        : FlatHashMap(
+              slot_traits::select_on_container_copy_construction(o.m_slot_alloc)) {
+        reserve(o.m_size);
+        for (auto& el : o) _insert_unique(el.first, el.second);
+    }
+    FlatHashMap(FlatHashMap&& o) noexcept
+        : m_slot_alloc(std::move(o.m_slot_alloc)),
+          m_ctrl_alloc(std::move(o.m_ctrl_alloc)),
+          m_ctrl(std::exchange(o.m_ctrl, nullptr)),
+          m_slots(std::exchange(o.m_slots, nullptr)),
+          m_capacity(std::exchange(o.m_capacity, 0)),
+          m_size(std::exchange(o.m_size, 0)),
+          m_growth_left(std::exchange(o.m_growth_left, 0)) {}
+
+    FlatHashMap& operator=(const FlatHashMap& o) {
+        if (this != &o) {
+            if constexpr (slot_traits::propagate_on_container_copy_assignment::value) {
+                // storage goes back to the allocator that made it
+                if (m_slot_alloc != o.m_slot_alloc) _destroy();
+                m_slot_alloc = o.m_slot_alloc;
+                m_ctrl_alloc = o.m_ctrl_alloc;
+            }
+            clear();
+            reserve(o.m_size);
+            for (auto& el : o) _insert_unique(el.first, el.second);
+        }
+        return *this;
+    }
+    FlatHashMap& operator=(FlatHashMap&& o) noexcept(
+        slot_traits::propagate_on_container_move_assignment::value ||
+        slot_traits::is_always_equal::value) {
+        constexpr bool propagate = slot_traits::propagate_on_container_move_assignment::value;
+        if (this == &o) return *this;
+        if (propagate || m_slot_alloc == o.m_slot_alloc) {
+            _destroy();
+            if constexpr (propagate) {
+                m_slot_alloc = std::move(o.m_slot_alloc);
+                m_ctrl_alloc = std::move(o.m_ctrl_alloc);
+            }
+            m_ctrl        = std::exchange(o.m_ctrl, nullptr);
+            m_slots       = std::exchange(o.m_slots, nullptr);
+            m_capacity    = std::exchange(o.m_capacity, 0);
+            m_size        = std::exchange(o.m_size, 0);
+            m_growth_left = std::exchange(o.m_growth_left, 0);
+        } else {
+            // our allocator can not free the other's storage, move the items over
+            clear();
+            reserve(o.m_size);
+            for (auto& el : o) _insert_unique(el.first, std::move(el.second));
+            o.clear();
+        }
+        return *this;
+    }
+
+    ~FlatHashMap() { _destroy(); }
+
+    auto begin() noexcept { return iterator { this, 0 }; }
+    auto end() noexcept { return iterator { this, m_capacity }; }
+    auto begin() const noexcept { return const_iterator { this, 0 }; }
+    auto end() const noexcept { return const_iterator { this, m_capacity }; }
+
+    auto size() const noexcept -> usize { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    auto capacity() const noexcept -> usize { return m_capacity; }
+    auto get_allocator() const -> allocator_type { return allocator_type(m_slot_alloc); }
+
+    void clear() noexcept {
+        if (m_capacity == 0) return;
+        for (usize i = 0; i < m_capacity; i++) {
+            if (m_ctrl[i] >= 0) slot_traits::destroy(m_slot_alloc, m_slots + i);
+        }
+        std::memset(m_ctrl, static_cast<std::uint8_t>(detail::ctrl_empty),
+                    m_capacity + group_type::width);
+        m_size        = 0;
+        m_growth_left = _max_load(m_capacity);
+    }
+
+    void reserve(usize n) {
+        if (n == 0 || (m_capacity && n <= m_size + m_growth_left)) return;
+        auto cap = min_capacity;
+        while (_max_load(cap) < n) cap *= 2;
+        _rehash(std::max(cap, m_capacity));
+    }
+
+    auto find(param_type<K> k) -> iterator { return { this, _find(k) }; }
+    auto find(param_type<K> k) const -> const_iterator { return { this, _find(k) }; }
+    bool contains(param_type<K> k) const { return _find(k) != m_capacity; }
+    auto count(param_type<K> k) const -> usize { return contains(k) ? 1 : 0; }
+
+    template<typename... Args>
+    auto try_emplace(const K& k, Args&&... args) -> std::pair<iterator, bool> {
+        auto hash = _hash(k);
+        if (auto idx = _find(k, hash); idx != m_capacity) return { { this, idx }, false };
+        auto idx = _prepare_insert(hash);
+        slot_traits::construct(m_slot_alloc,
+                               m_slots + idx,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(k),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        ++m_size;
+        return { { this, idx }, true };
+    }
+
+    auto insert(const value_type& v) -> std::pair<iterator, bool> {
+        return try_emplace(v.first, v.second);
+    }
+    template<typename P>
+        requires std::constructible_from<value_type, P&&>
+    auto insert(P&& p) -> std::pair<iterator, bool> {
+        return try_emplace(p.first, std::get<1>(std::forward<P>(p)));
+    }
+
+    template<typename M>
+    auto insert_or_assign(const K& k, M&& v) -> std::pair<iterator, bool> {
+        auto res = try_emplace(k, std::forward<M>(v));
+        if (! res.second) res.first->second = std::forward<M>(v);
+        return res;
+    }
+
+    auto operator[](const K& k) -> V& { return try_emplace(k).first->second; }
+
+    auto erase(iterator it) -> iterator {
+        _erase_at(it.m_idx);
+        ++it;
+        return it;
+    }
+    auto erase(const_iterator it) -> iterator { return erase(iterator { this, it.m_idx }); }
+    auto erase(param_type<K> k) -> usize {
+        if (auto idx = _find(k); idx != m_capacity) {
+            _erase_at(idx);
+            return 1;
+        }
+        return 0;
+    }
+
+private:
+    static constexpr auto _max_load(usize cap) noexcept -> usize { return cap - cap / 8; }
+
+    auto _hash(param_type<K> k) const -> usize { return detail::hash_mix(hasher {}(k)); }
+
+    void _set_ctrl(usize i, ctrl_t h) noexcept {
+        m_ctrl[i] = h;
+        // mirror the head so a group read starting near the end wraps around
+        if (i < group_type::width) m_ctrl[m_capacity + i] = h;
+    }
+
+    auto _find(param_type<K> k) const -> usize { return _find(k, _hash(k)); }
+    auto _find(param_type<K> k, usize hash) const -> usize {
+        if (m_capacity == 0) return 0;
+        const auto mask = m_capacity - 1;
+        const auto h2   = detail::hash_h2(hash);
+        auto       pos  = detail::hash_h1(hash) & mask;
+        for (usize step = group_type::width;; step += group_type::width) {
+            group_type g { m_ctrl + pos };
+            for (auto m = g.match(h2); m; m = group_type::next(m)) {
+                auto idx = (pos + group_type::lowest(m)) & mask;
+                if (key_equal {}(m_slots[idx].first, k)) return idx;
+            }
+            if (g.match_empty()) return m_capacity;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    auto _find_non_full(usize hash) const noexcept -> usize {
+        const auto mask = m_capacity - 1;
+        auto       pos  = detail::hash_h1(hash) & mask;
+        for (usize step = group_type::width;; step += group_type::width) {
+            group_type g { m_ctrl + pos };
+            if (auto m = g.match_empty_or_deleted()) {
+                return (pos + group_type::lowest(m)) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    auto _prepare_insert(usize hash) -> usize {
+        auto idx = m_capacity ? _find_non_full(hash) : 0;
+        if (m_capacity == 0 || (m_growth_left == 0 && m_ctrl[idx] != detail::ctrl_deleted)) {
+            // drop tombstones in place when they are the reason we ran out of room
+            auto cap = m_capacity == 0                    ? min_capacity
+                       : m_size * 16 <= m_capacity * 7 ? m_capacity
+                                                          : m_capacity * 2;
+            _rehash(cap);
+            idx = _find_non_full(hash);
+        }
+        if (m_ctrl[idx] == detail::ctrl_empty) --m_growth_left;
+        _set_ctrl(idx, detail::hash_h2(hash));
+        return idx;
+    }
+
+    template<typename M>
+    void _insert_unique(const K& k, M&& v) {
+        auto idx = _prepare_insert(_hash(k));
+        slot_traits::construct(m_slot_alloc, m_slots + idx, k, std::forward<M>(v));
+        ++m_size;
+    }
+
+    void _erase_at(usize idx) {
+        slot_traits::destroy(m_slot_alloc, m_slots + idx);
+        --m_size;
+
+        // a tombstone is only needed if some probe window through idx was ever full
+        const auto before      = (idx - group_type::width) & (m_capacity - 1);
+        const auto empty_after = group_type { m_ctrl + idx }.match_empty();
+        const auto empty_before = group_type { m_ctrl + before }.match_empty();
+        const bool never_full =
+            empty_before && empty_after &&
+            static_cast<usize>(std::countr_zero(empty_after) / 8 +
+                               std::countl_zero(empty_before) / 8) < group_type::width;
+        if (never_full) {
+            _set_ctrl(idx, detail::ctrl_empty);
+            ++m_growth_left;
+        } else {
+            _set_ctrl(idx, detail::ctrl_deleted);
+        }
+    }
+
+    void _rehash(usize cap) {
+        auto old_ctrl  = m_ctrl;
+        auto old_slots = m_slots;
+        auto old_cap   = m_capacity;
+
+        m_ctrl  = ctrl_traits::allocate(m_ctrl_alloc, cap + group_type::width);
+        m_slots = slot_traits::allocate(m_slot_alloc, cap);
+        std::memset(
+            m_ctrl, static_cast<std::uint8_t>(detail::ctrl_empty), cap + group_type::width);
+        m_capacity    = cap;
+        m_growth_left = _max_load(cap) - m_size;
+
+        for (usize i = 0; i < old_cap; i++) {
+            if (old_ctrl[i] < 0) continue;
+            auto& old  = old_slots[i];
+            auto  hash = _hash(old.first);
+            auto  idx  = _find_non_full(hash);
+            _set_ctrl(idx, detail::hash_h2(hash));
+            slot_traits::construct(m_slot_alloc,
+                                   m_slots + idx,
+                                   std::piecewise_construct,
+                                   std::forward_as_tuple(std::move(const_cast<K&>(old.first))),
+                                   std::forward_as_tuple(std::move(old.second)));
+            slot_traits::destroy(m_slot_alloc, old_slots + i);
+        }
+        if (old_cap) {
+            ctrl_traits::deallocate(m_ctrl_alloc, old_ctrl, old_cap + group_type::width);
+            slot_traits::deallocate(m_slot_alloc, old_slots, old_cap);
+        }
+    }
+
+    void _destroy() noexcept {
+        if (m_capacity == 0) return;
+        for (usize i = 0; i < m_capacity; i++) {
+            if (m_ctrl[i] >= 0) slot_traits::destroy(m_slot_alloc, m_slots + i);
+        }
+        ctrl_traits::deallocate(m_ctrl_alloc, m_ctrl, m_capacity + group_type::width);
+        slot_traits::deallocate(m_slot_alloc, m_slots, m_capacity);
+        m_ctrl        = nullptr;
+        m_slots       = nullptr;
+        m_capacity    = 0;
+        m_size        = 0;
+        m_growth_left = 0;
+    }
+
+    slot_alloc  m_slot_alloc;
+    ctrl_alloc  m_ctrl_alloc;
+    ctrl_t*     m_ctrl;
+    value_type* m_slots;
+    usize       m_capacity;
+    usize       m_size;
+    usize       m_growth_left;
+};
+
+} // namespace kstore
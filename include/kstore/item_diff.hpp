@@ -0,0 +1,46 @@
+#pragma once
+
+#include <concepts>
+#include <memory>
+
+#include <QtCore/QMetaObject>
+#include "kstore/item_trait.hpp"
+
+namespace kstore
+{
+
+///
+/// @brief Compare every readable Q_PROPERTY of two gadgets of type meta
+auto qgadget_diff(const QMetaObject& meta, const void* a, const void* b) -> change_mask;
+
+///
+/// @brief qgadget_diff for a gadget type, to opt in from ItemTrait<T>::diff
+/// @details Members that are not properties are not compared, use it only for gadgets whose
+/// whole content is in their properties.
+template<typename T>
+    requires requires { T::staticMetaObject; }
+auto gadget_diff(const T& old, const T& new_) -> change_mask {
+    return qgadget_diff(T::staticMetaObject, std::addressof(old), std::addressof(new_));
+}
+
+///
+/// @brief Changed fields between old and new
+/// @details
+/// Uses ItemTrait<T>::diff if defined, then ItemTrait<T>::fingerprint, then operator==.
+/// Returns change_mask_all when none of them applies. A mask of 0 only means nothing needs
+/// to be signalled, callers still write the new item.
+template<typename T>
+auto item_diff(const T& old, const T& new_) -> change_mask {
+    if constexpr (diffable_item<T>) {
+        return ItemTrait<T>::diff(old, new_);
+    } else if constexpr (fingerprinted_item<T>) {
+        return ItemTrait<T>::fingerprint(old) == ItemTrait<T>::fingerprint(new_) ? 0
+                                                                                 : change_mask_all;
+    } else if constexpr (std::equality_comparable<T>) {
+        return old == new_ ? 0 : change_mask_all;
+    } else {
+        return change_mask_all;
+    }
+}
+
+} // namespace kstore
@@ -14,6 +14,17 @@ template<typename T>
 using param_type =
     std::conditional_t<std::is_trivially_copyable_v<T> && sizeof(T) <= 16, T, const T&>;
 
+///
+/// @brief Changed fields of an item, bit i for the i-th Q_PROPERTY
+/// @details Fields from index 63 on share the highest bit.
+using change_mask = std::uint64_t;
+
+inline constexpr change_mask change_mask_all = ~change_mask { 0 };
+
+constexpr auto change_mask_bit(int index) noexcept -> change_mask {
+    return change_mask { 1 } << (index < 63 ? index : 63);
+}
+
 template<class T, template<class...> class Primary>
 struct is_specialization_of : std::false_type {};
 
@@ -37,6 +48,16 @@ concept special_of = is_specialization_of<T, Primary>::value;
 ///
 /// // storeable:
 /// using store_type = ...;
+///
+/// // diffable, bit i set when the i-th property differs, kstore::gadget_diff for gadgets
+/// // whose content is all in properties:
+/// auto diff(T old, T new) noexcept -> change_mask;
+///
+/// // fingerprinted, equal content gives equal values, used when diff is absent:
+/// auto fingerprint(T) noexcept -> std::uint64_t;
+///
+/// // sizeable, bytes held by an item, for the retention budget of ShareStore:
+/// auto byte_size(T) noexcept -> usize;
 /// @endcode
 /// @tparam Item type
 template<typename T>
@@ -66,6 +87,36 @@ concept comparable_item = std::semiregular<ItemTrait<T>> && requires(T t) {
     { ItemTrait<T>::compare_lt(t, t) } -> std::same_as<bool>;
 };
 
+///
+/// @brief Item that defined diff in ItemTrait
+template<typename T>
+concept diffable_item = std::semiregular<ItemTrait<T>> && requires(T t) {
+    { ItemTrait<T>::diff(t, t) } -> std::convertible_to<change_mask>;
+};
+
+///
+/// @brief Item that defined fingerprint in ItemTrait
+template<typename T>
+concept fingerprinted_item = std::semiregular<ItemTrait<T>> && requires(T t) {
+    { ItemTrait<T>::fingerprint(t) } -> std::convertible_to<std::uint64_t>;
+};
+
+///
+/// @brief Item that defined byte_size in ItemTrait
+template<typename T>
+concept sizeable_item = std::semiregular<ItemTrait<T>> && requires(T t) {
+    { ItemTrait<T>::byte_size(t) } -> std::convertible_to<usize>;
+};
+
+template<typename T>
+auto item_byte_size(const T& t) -> usize {
+    if constexpr (sizeable_item<T>) {
+        return ItemTrait<T>::byte_size(t);
+    } else {
+        return sizeof(T);
+    }
+}
+
 template<typename T>
     requires std::is_arithmetic_v<T>
 struct ItemTrait<T> {
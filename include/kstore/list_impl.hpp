@@ -1,15 +1,23 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <limits>
+#include <list>
 #include <ranges>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <set>
+#include <variant>
+#include <stdexcept>
 
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QPointer>
 #include "kstore/item_trait.hpp"
 #include "kstore/share_store.hpp"
+#include "kstore/order_tree.hpp"
+#include "kstore/qt/meta_role.hpp"
 
 namespace kstore
 {
@@ -18,7 +26,9 @@ enum class ListStoreType
     Vector = 0,
     VectorWithMap,
     Map,
-    Share
+    Share,
+    Tree,
+    Virtual
 };
 }
 
@@ -55,6 +65,174 @@ using HashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
 template<typename T, typename Allocator>
 using Set = std::set<T, std::less<>, rebind_alloc<Allocator, T>>;
 
+///
+/// @brief Call func(first, last) for each run of consecutive values, last is inclusive
+/// @param sorted ascending, without duplicates
+template<std::ranges::forward_range R, typename Func>
+void for_each_run(const R& sorted, Func&& func) {
+    auto it  = std::ranges::begin(sorted);
+    auto end = std::ranges::end(sorted);
+    while (it != end) {
+        auto first = *it;
+        auto last  = first;
+        while (++it != end && *it == last + 1) {
+            last = *it;
+        }
+        func(first, last);
+    }
+}
+
+///
+/// @brief One dataChanged per run of adjacent rows, with the roles of the run's merged mask
+/// @param changed (row, mask) pairs, ascending by row, without duplicate rows
+/// @details
+/// Every listed row is passed to QMetaRoleNames::rowsWritten first. Rows with a mask of 0
+/// were written but changed nothing item_diff sees, so they are not signalled.
+template<std::ranges::forward_range R>
+void emit_changed_runs(QAbstractListModel* model, const R& changed) {
+    auto roles = dynamic_cast<const QMetaRoleNames*>(model);
+    auto end   = std::ranges::end(changed);
+    if (roles) {
+        for (auto it = std::ranges::begin(changed); it != end;) {
+            usize first = it->first;
+            usize last  = first;
+            while (++it != end && it->first == last + 1) last = it->first;
+            roles->rowsWritten(first, last);
+        }
+    }
+    for (auto it = std::ranges::begin(changed); it != end;) {
+        if (it->second == 0) {
+            ++it;
+            continue;
+        }
+        usize       first = it->first;
+        usize       last  = first;
+        change_mask mask  = it->second;
+        while (++it != end && it->first == last + 1 && it->second != 0) {
+            last = it->first;
+            mask |= it->second;
+        }
+        model->dataChanged(model->index(first),
+                           model->index(last),
+                           roles ? roles->rolesOfMask(mask) : QList<int> {});
+    }
+}
+
+///
+/// @brief Mark one longest strictly increasing subsequence of seq, O(n log n)
+/// @param keep resized to seq's size, true for members
+/// @return length of the subsequence
+template<std::ranges::random_access_range R, typename Flags, typename Allocator>
+auto mark_lis(const R& seq, Flags& keep, Allocator alloc) -> usize {
+    constexpr auto npos = std::numeric_limits<usize>::max();
+    const usize    n    = std::ranges::size(seq);
+
+    // tails[k] is the index ending the best subsequence of length k + 1
+    std::vector<usize, rebind_alloc<Allocator, usize>> tails(alloc);
+    std::vector<usize, rebind_alloc<Allocator, usize>> prev(n, npos, alloc);
+    for (usize i = 0; i < n; i++) {
+        auto it = std::ranges::lower_bound(tails, seq[i], {}, [&seq](usize t) {
+            return seq[t];
+        });
+        if (it != tails.begin()) prev[i] = *(it - 1);
+        if (it == tails.end()) {
+            tails.push_back(i);
+        } else {
+            *it = i;
+        }
+    }
+
+    keep.assign(n, false);
+    for (auto i = tails.empty() ? npos : tails.back(); i != npos; i = prev[i]) {
+        keep[i] = true;
+    }
+    return tails.size();
+}
+
+///
+/// @brief Fenwick tree of row counts, O(log n) update and prefix sum
+template<typename Allocator>
+class PrefixSum {
+public:
+    PrefixSum(usize n, Allocator alloc): m_tree(n + 1, 0, alloc) {}
+
+    void add(usize i, usize v) {
+        for (i++; i < m_tree.size(); i += i & (~i + 1)) m_tree[i] += v;
+    }
+    void sub(usize i, usize v) {
+        for (i++; i < m_tree.size(); i += i & (~i + 1)) m_tree[i] -= v;
+    }
+    /// @return sum of [0, i)
+    auto prefix(usize i) const -> usize {
+        usize sum = 0;
+        for (; i > 0; i -= i & (~i + 1)) sum += m_tree[i];
+        return sum;
+    }
+
+private:
+    std::vector<usize, rebind_alloc<Allocator, usize>> m_tree;
+};
+
+///
+/// @brief Key to row map, repaired lazily
+/// @details
+/// Edits only lower a watermark, rows below it have an exact entry. A lookup past the
+/// watermark indexes forward in chunks until it reaches the key's row, so a burst of
+/// edits costs nothing until the next lookup.
+template<typename K, typename Allocator>
+class RowIndex {
+public:
+    using map_type = HashMap<K, usize, Allocator>;
+
+    static constexpr usize repair_chunk = 64;
+
+    RowIndex(Allocator alloc = Allocator()): m_map(alloc), m_valid(0) {}
+
+    auto contains(param_type<K> key) const { return m_map.contains(key); }
+    void insert(param_type<K> key, usize row) { m_map.insert_or_assign(key, row); }
+    void erase(param_type<K> key) { m_map.erase(key); }
+    void clear() {
+        m_map.clear();
+        m_valid = 0;
+    }
+    void invalidate(usize row) noexcept { m_valid = std::min(m_valid, row); }
+    void reserve(usize n) { m_map.reserve(n); }
+
+    ///
+    /// @param size row count
+    /// @param key_of key_of(row) -> K
+    template<typename F>
+    auto find(param_type<K> key, usize size, F&& key_of) const -> std::optional<usize> {
+        auto it = m_map.find(key);
+        if (it == m_map.end()) return std::nullopt;
+        // stale entries may point below the watermark too, check the row
+        while (! (it->second < m_valid && key_of(it->second) == key)) {
+            if (m_valid >= size) return std::nullopt;
+            repair(std::min(m_valid + repair_chunk, size), key_of);
+        }
+        return it->second;
+    }
+
+    ///
+    /// @brief Index rows up to row, exclusive
+    template<typename F>
+    void repair(usize row, F&& key_of) const {
+        for (; m_valid < row; m_valid++) {
+            // never inserts, lookups may hold iterators
+            if (auto it = m_map.find(key_of(m_valid)); it != m_map.end()) {
+                it->second = m_valid;
+            }
+        }
+    }
+
+    // exact only after repair(size)
+    auto& map() const noexcept { return m_map; }
+
+private:
+    mutable map_type m_map;
+    mutable usize    m_valid;
+};
+
 template<typename T, typename Allocator>
 class ListImpl<T, Allocator, ListStoreType::Vector> {
 public:
@@ -138,19 +316,16 @@ public:
     auto contains(param_type<T> t) const { return m_map.contains(ItemTrait<T>::key(t)); }
     auto key_at(usize idx) const { return ItemTrait<T>::key(m_items.at(idx)); }
     auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
-        if (auto it = m_map.find(key); it != m_map.end()) {
-            return it->second;
-        }
-        return std::nullopt;
+        return m_map.find(key, m_items.size(), key_of());
     };
     T* query(param_type<key_type> key) {
         auto idx = this->query_idx(key);
-        if (idx) return this->at(*idx);
+        if (idx) return std::addressof(this->at(*idx));
         return nullptr;
     }
     T const* query(param_type<key_type> key) const {
         auto idx = this->query_idx(key);
-        if (idx) return this->at(*idx);
+        if (idx) return std::addressof(this->at(*idx));
         return nullptr;
     }
 
@@ -165,10 +340,13 @@ protected:
 
     template<std::ranges::range U>
     void _insert_impl(usize idx, U&& range) {
+        auto old = m_items.size();
         std::ranges::copy(std::forward<U>(range), std::insert_iterator(m_items, begin() + idx));
-        for (auto i = idx; i < m_items.size(); i++) {
-            m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
+        // rows after the range shifted, they are repaired on lookup
+        for (auto i = idx; i < idx + (m_items.size() - old); i++) {
+            m_map.insert(ItemTrait<T>::key(m_items[i]), i);
         }
+        m_map.invalidate(idx);
     }
 
     void _erase_impl(usize idx, usize last) {
@@ -177,6 +355,7 @@ protected:
             m_map.erase(ItemTrait<T>::key(m_items.at(i)));
         }
         m_items.erase(it + idx, it + last);
+        m_map.invalidate(idx);
     }
 
     void _reset_impl() {
@@ -197,37 +376,42 @@ protected:
         auto dst = it + destinationRow;
         if (sourceRow > destinationRow) {
             std::rotate(dst, src, src + count);
-            for (auto i = destinationRow; i < sourceRow + count; i++) {
-                m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
-            }
         } else {
             std::rotate(src, src + count, dst);
-            for (auto i = sourceRow; i < destinationRow; i++) {
-                m_map.insert_or_assign(ItemTrait<T>::key(m_items.at(i)), i);
-            }
         }
+        m_map.invalidate(std::min(sourceRow, destinationRow));
     }
 
     template<std::ranges::sized_range R>
     void _reorder_impl(const R& new_order) {
+        m_map.repair(m_items.size(), key_of());
         container_type tmp(get_allocator());
         tmp.reserve(std::ranges::size(new_order));
         for (auto& key : new_order) {
-            tmp.push_back(std::move(m_items[m_map[key]]));
+            tmp.push_back(std::move(m_items[m_map.map().at(key)]));
         }
         m_items = std::move(tmp);
-        m_map.clear();
-        for (usize i = 0; i < m_items.size(); i++) {
-            m_map.insert_or_assign(ItemTrait<T>::key(m_items[i]), i);
-        }
+        // same keys, only the rows changed
+        m_map.invalidate(0);
+        m_map.repair(m_items.size(), key_of());
     }
 
-    auto& _maps() { return m_map; }
+    // every row indexed
+    auto& _maps() {
+        m_map.repair(m_items.size(), key_of());
+        return m_map.map();
+    }
 
 private:
+    auto key_of() const {
+        return [this](usize row) {
+            return ItemTrait<T>::key(m_items[row]);
+        };
+    }
+
     // indexed cache with hash
-    HashMap<key_type, usize, allocator_type> m_map;
-    container_type                           m_items;
+    RowIndex<key_type, allocator_type> m_map;
+    container_type                     m_items;
 };
 template<typename T, typename Allocator>
 class ListImpl<T, Allocator, ListStoreType::Map> {
@@ -346,54 +530,148 @@ public:
                            detail::rebind_alloc<Allocator, std::pair<const key_type, T>>>;
     using iterator = container_type::iterator;
 
+    // a store handing out shared snapshots, each row keeps the one last delivered to the list,
+    // so reads never touch an item another thread may replace
+    static constexpr bool snapshots =
+        ! std::is_pointer_v<decltype(std::declval<const store_type&>().store_at(StoreSlot {}))>;
+
     ListImpl(Allocator allc = Allocator())
         : m_order(allc),
           m_view(std::views::transform(m_order, Trans { this })),
-          m_notify_handle(0) {}
+          m_notify_handle(0),
+          m_changed_threshold(0) {}
 
     ~ListImpl() {
+        if (! m_store) return;
         m_store->store_unreg_notify(m_notify_handle);
         _reset_impl();
     }
 
+    // iterate by reference, resolved through store slots
     auto begin() const { return m_view.begin(); }
     auto end() const { return m_view.end(); }
     auto begin() { return m_view.begin(); }
     auto end() { return m_view.end(); }
     auto size() const { return m_order.size(); }
 
-    const auto& at(usize idx) const { return *query(m_order.at(idx)); }
-    auto&       at(usize idx) { return *query(m_order.at(idx)); }
-    auto        get_allocator() const { return m_order.get_allocator(); }
+    const auto& at(usize idx) const { return Trans { this }(m_order.at(idx)); }
+    // items of a snapshot store are immutable, edits go through _update_impl()
+    auto& at(usize idx)
+        requires(! snapshots)
+    {
+        return *m_store->store_at(m_order.at(idx).slot);
+    }
+
+    auto get_allocator() const { return m_order.get_allocator(); }
 
     // hash
     bool contains(param_type<T> t) const { return m_map.contains(ItemTrait<T>::key(t)); }
-    auto key_at(usize idx) const { return m_order.at(idx); }
+    auto key_at(usize idx) const { return m_order.at(idx).key; }
 
     auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
-        if (auto it = m_map.find(key); it != m_map.end()) return it->second;
-        return std::nullopt;
+        return m_map.find(key, m_order.size(), key_of());
+    }
+    auto query(param_type<key_type> key) { return m_store->store_query(key); }
+    auto query(param_type<key_type> key) const {
+        using pointer = std::conditional_t<snapshots, std::shared_ptr<const T>, T const*>;
+        return pointer { m_store->store_query(key) };
     }
-    T*       query(param_type<key_type> key) { return m_store->store_query(key); }
-    T const* query(param_type<key_type> key) const { return m_store->store_query(key); }
 
     void set_store(QAbstractListModel* self, store_type store) {
         m_store = store;
 
         // TODO: no void*
-        auto list       = QPointer { self };
-        m_notify_handle = m_store->store_reg_notify([list, this](std::span<const key_type> keys) {
+        auto list     = QPointer { self };
+        auto roles    = dynamic_cast<const QMetaRoleNames*>(self);
+        auto callback = [list, roles, this](std::span<const key_type>    keys,
+                                            std::span<const change_mask> masks) {
             if (! list) return;
-            for (auto& key : keys) {
-                if (auto it = m_map.find(key); it != m_map.end()) {
-                    auto idx = list->index(it->second);
-                    list->dataChanged(idx, idx);
+            auto roles_of = [roles](change_mask mask) {
+                return roles ? roles->rolesOfMask(mask) : QList<int> {};
+            };
+
+            std::vector<std::pair<usize, change_mask>,
+                        detail::rebind_alloc<allocator_type, std::pair<usize, change_mask>>>
+                changed(get_allocator());
+            changed.reserve(keys.size());
+            for (usize i = 0; i < keys.size(); i++) {
+                if (auto row = query_idx(keys[i])) {
+                    if constexpr (snapshots) refresh(*row);
+                    changed.emplace_back(*row, masks[i]);
                 }
             }
-        });
+            if (changed.empty()) return;
+
+            if (m_changed_threshold > 0 && changed.size() > m_changed_threshold) {
+                change_mask mask = 0;
+                for (auto& el : changed) mask |= el.second;
+                if (roles) roles->rowsWritten(0, size() - 1);
+                if (mask != 0) {
+                    list->dataChanged(list->index(0), list->index(size() - 1), roles_of(mask));
+                }
+                return;
+            }
+
+            // merge masks of the same row
+            std::ranges::sort(changed, {}, &std::pair<usize, change_mask>::first);
+            auto merged = changed.begin();
+            for (auto it = changed.begin() + 1; it != changed.end(); ++it) {
+                if (it->first == merged->first) {
+                    merged->second |= it->second;
+                } else {
+                    *++merged = *it;
+                }
+            }
+            changed.erase(merged + 1, changed.end());
+
+            // one signal per run of adjacent rows, with the roles of the whole run
+            emit_changed_runs(list.data(), changed);
+        };
+        if constexpr (requires { m_store->store_reg_notify(callback, {}); }) {
+            // concurrent store, deliver on the model's thread
+            auto executor = [list](std::function<void()> f) {
+                if (list) QMetaObject::invokeMethod(list.data(), std::move(f), Qt::AutoConnection);
+            };
+            m_notify_handle = m_store->store_reg_notify(callback, executor);
+        } else if constexpr (routed) {
+            m_notify_handle = m_store->store_reg_routed_notify(callback);
+            subscribe(m_order);
+        } else {
+            m_notify_handle = m_store->store_reg_notify(callback);
+        }
     }
 
+    ///
+    /// @brief Store updates touching more than n rows emit one whole-model dataChanged
+    /// @param n 0 to disable
+    void set_changed_threshold(usize n) { m_changed_threshold = n; }
+    auto changed_threshold() const -> usize { return m_changed_threshold; }
+
 protected:
+    ///
+    /// @brief Edit the item of a row, func(T&) returns whether it changed anything
+    /// @details
+    /// A snapshot store gets the edited copy as an update, so every list over the store sees
+    /// it and the others are notified. Otherwise the store's item is edited in place.
+    template<typename F>
+    bool _update_impl(usize idx, F&& func) {
+        if constexpr (snapshots) {
+            T item(std::as_const(*this).at(idx));
+            // the key names the item in the store, a changed one is not written
+            if (! func(item) || ItemTrait<T>::key(item) != key_at(idx)) return false;
+            m_store->store_upsert_many(
+                std::array { std::move(item) },
+                [](param_type<key_type>, StoreSlot) -> usize {
+                    return 0;
+                },
+                m_notify_handle);
+            refresh(idx);
+            return true;
+        } else {
+            return func(at(idx));
+        }
+    }
+
     template<std::ranges::sized_range U>
     auto _insert_len(U&& range) {
         auto view = std::views::transform(range, [this](auto& el) -> usize {
@@ -404,40 +682,53 @@ protected:
 
     template<std::ranges::range U>
     void _insert_impl(usize it, U&& range) {
-        std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> order(
+        order_type order(get_allocator());
+        // rows already here, this list is not notified of its own update
+        std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> kept(
             get_allocator());
-        std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> keys(get_allocator());
-        for (auto&& el : std::forward<U>(range)) {
-            auto k = ItemTrait<T>::key(el);
-            keys.emplace_back(k);
-            if (m_map.contains(k)) {
-                m_store->store_insert(std::forward<decltype(el)>(el));
-            } else {
-                m_map.insert({ k, it + order.size() });
-                order.emplace_back(k);
-                auto [item, _] = m_store->store_insert(std::forward<decltype(el)>(el));
+        m_store->store_upsert_many(
+            std::forward<U>(range),
+            [this, it, &order, &kept](param_type<key_type> k, StoreSlot slot) -> usize {
+                if (m_map.contains(k)) {
+                    if constexpr (snapshots) kept.push_back(k);
+                    return 0;
+                }
+                m_map.insert(k, it + order.size());
+                order.push_back({ k, slot });
                 // mark as keeped in struct
-                item.increase();
-            }
+                return 1;
+            },
+            m_notify_handle);
+        if constexpr (snapshots) {
+            for (auto& e : order) e.snapshot = m_store->store_at(e.slot);
         }
         m_order.insert(m_order.begin() + it, order.begin(), order.end());
-        m_store->store_changed_callback(keys, m_notify_handle);
+        m_map.invalidate(it);
+        subscribe(order);
+        if constexpr (snapshots) {
+            for (auto& k : kept) {
+                if (auto row = query_idx(k)) refresh(*row);
+            }
+        }
     }
 
     void _erase_impl(usize index, usize last) {
         auto it    = m_order.begin();
         auto begin = it + index;
         auto end   = it + last;
+        unsubscribe(std::ranges::subrange(begin, end));
         for (auto it = begin; it != end; it++) {
-            m_map.erase(*it);
-            m_store->store_remove(*it);
+            m_map.erase(it->key);
+            m_store->store_remove(it->key);
         }
         m_order.erase(it + index, it + last);
+        m_map.invalidate(index);
     }
 
     void _reset_impl() {
-        for (auto& k : m_order) {
-            m_store->store_remove(k);
+        unsubscribe(m_order);
+        for (auto& e : m_order) {
+            m_store->store_remove(e.key);
         }
         m_map.clear();
         m_order.clear();
@@ -445,8 +736,9 @@ protected:
 
     template<std::ranges::range U>
     void _reset_impl(U&& items) {
-        for (auto& k : m_order) {
-            m_store->store_remove(k);
+        unsubscribe(m_order);
+        for (auto& e : m_order) {
+            m_store->store_remove(e.key);
         }
         m_map.clear();
         m_order.clear();
@@ -459,40 +751,480 @@ protected:
         auto dst = it + destinationRow;
         if (sourceRow > destinationRow) {
             std::rotate(dst, src, src + count);
-            for (auto i = destinationRow; i < sourceRow + count; i++) {
-                m_map.insert_or_assign(m_order.at(i), i);
-            }
         } else {
             std::rotate(src, src + count, dst);
-            for (auto i = sourceRow; i < destinationRow; i++) {
-                m_map.insert_or_assign(m_order.at(i), i);
-            }
         }
+        m_map.invalidate(std::min(sourceRow, destinationRow));
     }
 
     template<std::ranges::sized_range R>
     void _reorder_impl(const R& new_order) {
-        m_order.assign(std::ranges::begin(new_order), std::ranges::end(new_order));
-        m_map.clear();
-        for (usize i = 0; i < m_order.size(); i++) {
-            m_map.insert_or_assign(m_order[i], i);
+        HashMap<key_type, Entry, allocator_type> entries(get_allocator());
+        entries.reserve(m_order.size());
+        for (auto& e : m_order) {
+            entries.insert({ e.key, e });
         }
+        m_order.clear();
+        for (auto& key : new_order) {
+            m_order.push_back(entries.at(key));
+        }
+        // same keys, only the rows changed
+        m_map.invalidate(0);
+        m_map.repair(m_order.size(), key_of());
     }
 
 private:
+    using snapshot_type = std::conditional_t<snapshots, std::shared_ptr<const T>, std::monostate>;
+    struct Entry {
+        key_type  key;
+        StoreSlot slot;
+        // snapshot stores only
+        [[no_unique_address]] snapshot_type snapshot {};
+    };
+    using order_type = std::vector<Entry, detail::rebind_alloc<allocator_type, Entry>>;
+
+    void refresh(usize row) {
+        auto& e = m_order[row];
+        if (auto snapshot = m_store->store_at(e.slot)) e.snapshot = std::move(snapshot);
+    }
+
+    // a routed store only calls back with the keys this list subscribed to
+    static constexpr bool routed = requires(store_type& s, std::span<const key_type> keys) {
+        s.store_reg_routed_notify(typename store_type::callback_type {});
+        s.store_subscribe(std::int64_t {}, keys);
+    };
+
+    template<std::ranges::range R>
+    void subscribe(R&& entries) {
+        if constexpr (routed) {
+            if (! m_notify_handle) return;
+            m_store->store_subscribe(m_notify_handle, entries | std::views::transform(&Entry::key));
+        }
+    }
+
+    template<std::ranges::range R>
+    void unsubscribe(R&& entries) {
+        if constexpr (routed) {
+            if (! m_notify_handle) return;
+            m_store->store_unsubscribe(m_notify_handle, entries | std::views::transform(&Entry::key));
+        }
+    }
+
+    auto key_of() const {
+        return [this](usize row) -> const key_type& {
+            return m_order[row].key;
+        };
+    }
+
     struct Trans {
-        ListImpl* self;
+        const ListImpl* self;
 
-        T operator()(param_type<key_type> key) { return *(self->query(key)); }
+        auto operator()(const Entry& e) const -> std::conditional_t<snapshots, const T&, T&> {
+            if constexpr (snapshots) {
+                return (*e.snapshot);
+            } else {
+                return *(self->m_store->store_at(e.slot));
+            }
+        }
     };
 
-    std::vector<key_type, detail::rebind_alloc<allocator_type, key_type>> m_order;
-    HashMap<key_type, usize, allocator_type>                              m_map;
+    order_type                         m_order;
+    RowIndex<key_type, allocator_type> m_map;
 
     std::ranges::transform_view<std::ranges::ref_view<decltype(m_order)>, Trans> m_view;
 
     std::int64_t              m_notify_handle;
+    usize                     m_changed_threshold;
     std::optional<store_type> m_store;
 };
 
+template<typename T, typename Allocator>
+class ListImpl<T, Allocator, ListStoreType::Tree> {
+public:
+    using allocator_type = Allocator;
+    using key_type       = ItemTrait<T>::key_type;
+    using container_type = OrderTree<T, Allocator>;
+    using node_type      = container_type::Node;
+    using iterator       = container_type::iterator;
+
+    ListImpl(Allocator allc = Allocator()): m_map(allc), m_items(allc) {}
+
+    auto        begin() const { return std::begin(m_items); }
+    auto        end() const { return std::end(m_items); }
+    auto        begin() { return std::begin(m_items); }
+    auto        end() { return std::end(m_items); }
+    auto        size() const { return m_items.size(); }
+    const auto& at(usize idx) const { return node_at(idx)->value; }
+    auto&       at(usize idx) { return node_at(idx)->value; }
+    auto        get_allocator() const { return m_items.get_allocator(); }
+
+    // hash
+    auto contains(param_type<T> t) const { return m_map.contains(ItemTrait<T>::key(t)); }
+    auto key_at(usize idx) const { return ItemTrait<T>::key(at(idx)); }
+
+    // rank of the node, O(log n)
+    auto query_idx(param_type<key_type> key) const -> std::optional<usize> {
+        if (auto it = m_map.find(key); it != m_map.end()) return container_type::rank(it->second);
+        return std::nullopt;
+    }
+    T* query(param_type<key_type> key) {
+        if (auto it = m_map.find(key); it != m_map.end()) return std::addressof(it->second->value);
+        return nullptr;
+    }
+    T const* query(param_type<key_type> key) const {
+        if (auto it = m_map.find(key); it != m_map.end()) return std::addressof(it->second->value);
+        return nullptr;
+    }
+
+protected:
+    template<std::ranges::sized_range U>
+    auto _insert_len(U&& range) {
+        auto view = std::views::transform(range, [this](auto& el) -> usize {
+            return m_map.contains(ItemTrait<T>::key(el)) ? 0 : 1;
+        });
+        return std::accumulate(view.begin(), view.end(), 0);
+    }
+
+    template<std::ranges::range U>
+    void _insert_impl(usize idx, U&& range) {
+        node_vector nodes(get_allocator());
+        for (auto&& el : std::forward<U>(range)) {
+            auto k = ItemTrait<T>::key(el);
+            // existing key, update in place like Share
+            if (auto it = m_map.find(k); it != m_map.end()) {
+                it->second->value = std::forward<decltype(el)>(el);
+                continue;
+            }
+            auto node = m_items.make_node(std::forward<decltype(el)>(el));
+            m_map.insert({ k, node });
+            nodes.push_back(node);
+        }
+        m_items.insert(idx, nodes);
+    }
+
+    void _erase_impl(usize idx, usize last) {
+        m_items.erase(idx, last, [this](node_type* node) {
+            m_map.erase(ItemTrait<T>::key(node->value));
+        });
+    }
+
+    void _reset_impl() {
+        m_items.clear();
+        m_map.clear();
+    }
+
+    template<std::ranges::range U>
+    void _reset_impl(U&& items) {
+        m_items.clear();
+        m_map.clear();
+        _insert_impl(0, std::forward<U>(items));
+    }
+
+    void _move_impl(usize sourceRow, usize destinationRow, usize count) {
+        m_items.move(sourceRow, destinationRow, count);
+    }
+
+    template<std::ranges::sized_range R>
+    void _reorder_impl(const R& new_order) {
+        node_vector nodes(get_allocator());
+        nodes.reserve(std::ranges::size(new_order));
+        for (auto& key : new_order) {
+            nodes.push_back(m_map.at(key));
+        }
+        m_items.assign(nodes);
+    }
+
+private:
+    using node_vector = std::vector<node_type*, detail::rebind_alloc<allocator_type, node_type*>>;
+
+    auto node_at(usize idx) const -> node_type* {
+        auto node = m_items.at(idx);
+        if (! node) throw std::out_of_range("ListImpl::at");
+        return node;
+    }
+
+    HashMap<key_type, node_type*, allocator_type> m_map;
+    container_type                                m_items;
+};
+
+///
+/// @brief Rows materialized in fixed-size blocks on demand
+/// @details
+/// size() is a total set up front, only blocks that were read are kept. Reading a row of a
+/// block that is not resident returns the placeholder and asks the loader for the block,
+/// once until it is filled. The loader is called from the event loop, never from inside a
+/// read. Past max_blocks resident blocks the least recently read one is evicted. Structural
+/// edits shift the total and drop the blocks at and after the edit, they load again when
+/// read. Inserted rows stay in the blocks they complete. Keys of all rows are unknown, so
+/// keyed lookups are not offered.
+template<typename T, typename Allocator>
+class ListImpl<T, Allocator, ListStoreType::Virtual> {
+public:
+    using allocator_type = Allocator;
+    using key_type       = ItemTrait<T>::key_type;
+    // wants rows [offset, offset + count), answer with fill(offset, rows) later
+    using loader_type = std::function<void(usize offset, usize count)>;
+
+    ListImpl(Allocator allc = Allocator())
+        : m_blocks(allc),
+          m_lru(allc),
+          m_pending(allc),
+          m_queued(allc),
+          m_total(0),
+          m_block_size(256),
+          m_max_blocks(64),
+          m_last(nullptr),
+          m_last_id(0) {}
+
+    auto        size() const { return m_total; }
+    const auto& at(usize idx) const { return *row_at(idx); }
+    auto&       at(usize idx) { return *row_at(idx); }
+    auto        get_allocator() const { return allocator_type(m_lru.get_allocator()); }
+
+    ///
+    /// @brief Key of a row, the placeholder's key while its block is not resident
+    /// @details Check loaded() first where that matters. Lookups by key are not offered, they
+    /// could not tell unloaded rows apart.
+    auto key_at(usize idx) const { return ItemTrait<T>::key(at(idx)); }
+
+    void set_loader(QAbstractListModel* self, loader_type loader) {
+        m_list   = self;
+        m_loader = std::move(loader);
+    }
+
+    ///
+    /// @brief Rows per block, drops all resident blocks
+    void set_block_size(usize n) {
+        m_block_size = std::max<usize>(n, 1);
+        drop(0, m_total);
+    }
+    auto block_size() const -> usize { return m_block_size; }
+
+    ///
+    /// @brief Cap of resident blocks, memory is about n * block_size items
+    void set_max_blocks(usize n) {
+        m_max_blocks = std::max<usize>(n, 1);
+        evict();
+    }
+    auto max_blocks() const -> usize { return m_max_blocks; }
+
+    ///
+    /// @brief Row read while its block is not resident
+    void set_placeholder(param_type<T> t) { m_placeholder = t; }
+    auto placeholder() const -> const T& { return m_placeholder; }
+
+    auto loaded(usize idx) const -> bool { return m_blocks.contains(idx / m_block_size); }
+    auto resident_blocks() const -> usize { return m_blocks.size(); }
+
+    ///
+    /// @brief Answer the loader, rows of blocks that were not requested are ignored
+    /// @param offset first row of a block
+    /// @return rows taken
+    template<std::ranges::sized_range R>
+    auto fill(usize offset, R&& rows) -> usize {
+        if (offset % m_block_size != 0) return 0;
+        usize taken = 0;
+        usize n     = std::ranges::size(rows);
+        auto  it    = std::ranges::begin(rows);
+        for (usize done = 0; done < n && offset + done < m_total;) {
+            auto row   = offset + done;
+            auto id    = row / m_block_size;
+            auto count = std::min({ m_block_size, n - done, m_total - row });
+            // whole blocks only, and only those still wanted
+            if (count == std::min(m_block_size, m_total - row) && m_pending.erase(id)) {
+                place(id, it, count);
+                taken += count;
+                if (m_list) m_list->dataChanged(m_list->index(row), m_list->index(row + count - 1));
+            }
+            it = std::ranges::next(it, count);
+            done += count;
+        }
+        evict();
+        return taken;
+    }
+
+protected:
+    template<std::ranges::sized_range U>
+    auto _insert_len(U&& range) {
+        return std::ranges::size(range);
+    }
+
+    // a block around the inserted rows stays when its other rows are resident
+    template<std::ranges::range U>
+    void _insert_impl(usize idx, U&& range) {
+        using item_vec = std::vector<T, allocator_type>;
+        item_vec rows(get_allocator());
+        for (auto&& el : range) rows.push_back(std::forward<decltype(el)>(el));
+        const usize n     = rows.size();
+        const usize total = m_total + n;
+
+        // rows by their index after the insert
+        auto row_of = [&, this](usize r) -> const T* {
+            if (r >= idx && r < idx + n) return std::addressof(rows[r - idx]);
+            auto old = r < idx ? r : r - n;
+            auto it  = m_blocks.find(old / m_block_size);
+            if (it == m_blocks.end()) return nullptr;
+            return std::addressof(it->second.items[old % m_block_size]);
+        };
+        std::vector<std::pair<usize, item_vec>,
+                    detail::rebind_alloc<allocator_type, std::pair<usize, item_vec>>>
+            kept(get_allocator());
+        for (usize id = idx / m_block_size; id * m_block_size < idx + n; id++) {
+            auto     first = id * m_block_size;
+            auto     count = std::min(m_block_size, total - first);
+            item_vec items(get_allocator());
+            items.reserve(count);
+            for (usize r = first; r < first + count; r++) {
+                auto p = row_of(r);
+                if (! p) break;
+                items.push_back(*p);
+            }
+            if (items.size() == count) kept.emplace_back(id, std::move(items));
+        }
+
+        // a partial last block grows too
+        drop(idx, std::max(idx + 1, m_total));
+        m_total = total;
+        for (auto& [id, items] : kept) {
+            place(id, std::make_move_iterator(items.begin()), items.size());
+        }
+        evict();
+    }
+
+    void _erase_impl(usize idx, usize last) {
+        drop(idx, m_total);
+        m_total -= last - idx;
+    }
+
+    void _reset_impl() { _resize_impl(0); }
+
+    template<std::ranges::sized_range U>
+    void _reset_impl(U&& items) {
+        _resize_impl(std::ranges::size(items));
+        auto it = std::ranges::begin(items);
+        for (usize row = 0; row < m_total; row += m_block_size) {
+            auto count = std::min(m_block_size, m_total - row);
+            place(row / m_block_size, it, count);
+            it = std::ranges::next(it, count);
+        }
+        evict();
+    }
+
+    void _resize_impl(usize total) {
+        drop(0, m_total);
+        m_total = total;
+    }
+
+    void _move_impl(usize sourceRow, usize destinationRow, usize count) {
+        drop(std::min(sourceRow, destinationRow), std::max(sourceRow + count, destinationRow));
+    }
+
+private:
+    using lru_list = std::list<usize, detail::rebind_alloc<allocator_type, usize>>;
+    using id_vec   = std::vector<usize, detail::rebind_alloc<allocator_type, usize>>;
+    struct Block {
+        std::vector<T, allocator_type> items;
+        lru_list::iterator             lru;
+    };
+
+    auto row_at(usize idx) const -> T* {
+        if (idx >= m_total) throw std::out_of_range("ListImpl::at");
+        auto id = idx / m_block_size;
+        if (auto b = block(id)) return std::addressof(b->items[idx - id * m_block_size]);
+        request(id);
+        // writes to a missing row are dropped with the copy
+        m_hole = m_placeholder;
+        return std::addressof(m_hole);
+    }
+
+    auto block(usize id) const -> Block* {
+        // the last block read is already the most recent
+        if (m_last && m_last_id == id) return m_last;
+        auto it = m_blocks.find(id);
+        if (it == m_blocks.end()) return nullptr;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        m_last    = &it->second;
+        m_last_id = id;
+        return m_last;
+    }
+
+    // at() may run inside a view's paint or data(), the loader waits for the event loop
+    void request(usize id) const {
+        if (! m_loader || ! m_pending.insert(id).second) return;
+        m_queued.push_back(id);
+        if (m_queued.size() > 1) return;
+        if (m_list) {
+            QMetaObject::invokeMethod(
+                m_list.data(),
+                [this] {
+                    flush();
+                },
+                Qt::QueuedConnection);
+        } else {
+            flush();
+        }
+    }
+
+    void flush() const {
+        auto queued = std::move(m_queued);
+        m_queued.clear();
+        for (auto id : queued) {
+            // dropped since, or already filled
+            if (! m_loader || ! m_pending.contains(id)) continue;
+            auto offset = id * m_block_size;
+            m_loader(offset, std::min(m_block_size, m_total - offset));
+        }
+    }
+
+    template<typename It>
+    void place(usize id, It first, usize count) {
+        m_lru.push_front(id);
+        Block b { std::vector<T, allocator_type>(get_allocator()), m_lru.begin() };
+        b.items.reserve(count);
+        for (usize i = 0; i < count; ++i, ++first) b.items.push_back(*first);
+        m_blocks.insert_or_assign(id, std::move(b));
+        m_last = nullptr;
+    }
+
+    void evict() {
+        while (m_blocks.size() > m_max_blocks) {
+            m_blocks.erase(m_lru.back());
+            m_lru.pop_back();
+        }
+        m_last = nullptr;
+    }
+
+    // blocks holding rows [first, last), requests for them are forgotten
+    void drop(usize first, usize last) {
+        if (first >= last) return;
+        auto lo = first / m_block_size;
+        auto hi = (last - 1) / m_block_size;
+        std::erase_if(m_blocks, [this, lo, hi](auto& el) {
+            if (el.first < lo || el.first > hi) return false;
+            m_lru.erase(el.second.lru);
+            return true;
+        });
+        auto in_range = [lo, hi](usize id) {
+            return id >= lo && id <= hi;
+        };
+        std::erase_if(m_pending, in_range);
+        std::erase_if(m_queued, in_range);
+        m_last = nullptr;
+    }
+
+    mutable HashMap<usize, Block, allocator_type> m_blocks;
+    mutable lru_list                              m_lru;
+    mutable Set<usize, allocator_type>            m_pending;
+    mutable id_vec                                m_queued;
+    usize                                         m_total;
+    usize                                         m_block_size;
+    usize                                         m_max_blocks;
+    T                                             m_placeholder {};
+    mutable T                                     m_hole {};
+    mutable Block*                                m_last;
+    mutable usize                                 m_last_id;
+    QPointer<QAbstractListModel>                  m_list;
+    loader_type                                   m_loader;
+};
+
 } // namespace kstore::detail
\ No newline at end of file
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "kstore/item_trait.hpp"
+
+namespace kstore::detail
+{
+
+///
+/// @brief Sequence kept in an implicit treap with subtree counts
+/// @details
+/// Position is implied by subtree sizes, so insert, erase, move and at() are O(log n)
+/// expected. Nodes have parent links and never move, a Node* stays valid until erased
+/// and rank(node) gives its position by walking up.
+template<typename T, typename Allocator>
+class OrderTree {
+public:
+    struct Node {
+        template<typename... Args>
+        Node(Args&&... args): value(std::forward<Args>(args)...) {}
+
+        T             value;
+        Node*         left { nullptr };
+        Node*         right { nullptr };
+        Node*         parent { nullptr };
+        std::uint32_t size { 1 };
+        std::uint32_t priority { 0 };
+    };
+
+    template<bool Const>
+    class Iter {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+
+        Iter(): m_node(nullptr) {}
+        explicit Iter(Node* node): m_node(node) {}
+        template<bool C>
+            requires(Const && ! C)
+        Iter(const Iter<C>& o): m_node(o.node()) {}
+
+        auto  node() const noexcept { return m_node; }
+        auto  operator*() const -> reference { return m_node->value; }
+        auto  operator->() const -> pointer { return std::addressof(m_node->value); }
+        Iter& operator++() {
+            m_node = OrderTree::next(m_node);
+            return *this;
+        }
+        Iter operator++(int) {
+            auto out = *this;
+            ++*this;
+            return out;
+        }
+        bool operator==(const Iter& o) const { return m_node == o.m_node; }
+
+    private:
+        Node* m_node;
+    };
+
+    // released node storage, kept for reuse
+    struct FreeNode {
+        FreeNode* next;
+    };
+    static_assert(sizeof(FreeNode) <= sizeof(Node) && alignof(FreeNode) <= alignof(Node));
+
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using node_traits    = std::allocator_traits<node_allocator>;
+    using ptr_vector =
+        std::vector<Node*, typename std::allocator_traits<Allocator>::template rebind_alloc<Node*>>;
+    using iterator       = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    OrderTree(Allocator alloc = Allocator {})
+        : m_alloc(alloc), m_root(nullptr), m_free(nullptr), m_seed(0x9E3779B9u) {}
+    ~OrderTree() {
+        clear();
+        while (m_free) {
+            auto n = std::exchange(m_free, m_free->next);
+            node_traits::deallocate(m_alloc, storage_of(n), 1);
+        }
+    }
+    OrderTree(const OrderTree&)            = delete;
+    OrderTree& operator=(const OrderTree&) = delete;
+
+    auto begin() const { return const_iterator { leftmost(m_root) }; }
+    auto end() const { return const_iterator {}; }
+    auto begin() { return iterator { leftmost(m_root) }; }
+    auto end() { return iterator {}; }
+    auto size() const noexcept -> usize { return size_of(m_root); }
+    auto get_allocator() const { return Allocator(m_alloc); }
+
+    auto at(usize idx) const -> Node* {
+        auto n = m_root;
+        while (n) {
+            auto left = size_of(n->left);
+            if (idx < left) {
+                n = n->left;
+            } else if (idx == left) {
+                return n;
+            } else {
+                idx -= left + 1;
+                n = n->right;
+            }
+        }
+        return nullptr;
+    }
+
+    static auto rank(const Node* n) -> usize {
+        usize out = size_of(n->left);
+        for (; n->parent; n = n->parent) {
+            if (n == n->parent->right) out += size_of(n->parent->left) + 1;
+        }
+        return out;
+    }
+
+    ///
+    /// @brief Allocate a detached node, link it with insert
+    template<typename... Args>
+    auto make_node(Args&&... args) -> Node* {
+        Node* n;
+        if (m_free) {
+            n = storage_of(std::exchange(m_free, m_free->next));
+        } else {
+            n = node_traits::allocate(m_alloc, 1);
+        }
+        node_traits::construct(m_alloc, n, std::forward<Args>(args)...);
+        n->priority = random();
+        return n;
+    }
+
+    ///
+    /// @brief Link detached nodes before idx, in order
+    void insert(usize idx, std::span<Node* const> nodes) {
+        if (nodes.empty()) return;
+        auto [left, right] = split(m_root, idx);
+        m_root             = merge(merge(left, build(nodes)), right);
+        m_root->parent     = nullptr;
+    }
+
+    ///
+    /// @brief Erase [first, last), on_erase sees each node before it is freed
+    template<typename F>
+    void erase(usize first, usize last, F&& on_erase) {
+        if (first >= last) return;
+        auto [left, rest] = split(m_root, first);
+        auto [mid, right] = split(rest, last - first);
+        m_root            = merge(left, right);
+        if (m_root) m_root->parent = nullptr;
+        free_tree(mid, on_erase);
+    }
+
+    ///
+    /// @brief Same contract as QAbstractItemModel::moveRows, dst is a row before the move
+    void move(usize src, usize dst, usize count) {
+        auto [left, rest] = split(m_root, src);
+        auto [mid, right] = split(rest, count);
+        auto others       = merge(left, right);
+        auto to           = dst > src ? dst - count : dst;
+        auto [a, b]       = split(others, to);
+        m_root            = merge(merge(a, mid), b);
+        if (m_root) m_root->parent = nullptr;
+    }
+
+    ///
+    /// @brief Relink all current nodes in a new order
+    void assign(std::span<Node* const> nodes) {
+        m_root = build(nodes);
+        if (m_root) m_root->parent = nullptr;
+    }
+
+    void clear() {
+        free_tree(m_root, [](Node*) {
+        });
+        m_root = nullptr;
+    }
+
+    static auto next(Node* n) -> Node* {
+        if (n->right) return leftmost(n->right);
+        while (n->parent && n == n->parent->right) n = n->parent;
+        return n->parent;
+    }
+
+private:
+    static auto size_of(const Node* n) noexcept -> usize { return n ? n->size : 0; }
+    static auto leftmost(Node* n) -> Node* {
+        if (n) {
+            while (n->left) n = n->left;
+        }
+        return n;
+    }
+    static void update(Node* n) noexcept {
+        n->size = static_cast<std::uint32_t>(size_of(n->left) + size_of(n->right) + 1);
+        if (n->left) n->left->parent = n;
+        if (n->right) n->right->parent = n;
+    }
+
+    // first k nodes to the left, parents of the returned roots are stale
+    static auto split(Node* n, usize k) -> std::pair<Node*, Node*> {
+        if (! n) return { nullptr, nullptr };
+        if (k <= size_of(n->left)) {
+            auto [a, b] = split(n->left, k);
+            n->left     = b;
+            update(n);
+            return { a, n };
+        } else {
+            auto [a, b] = split(n->right, k - size_of(n->left) - 1);
+            n->right    = a;
+            update(n);
+            return { n, b };
+        }
+    }
+
+    static auto merge(Node* a, Node* b) -> Node* {
+        if (! a) return b;
+        if (! b) return a;
+        if (a->priority > b->priority) {
+            a->right = merge(a->right, b);
+            update(a);
+            return a;
+        } else {
+            b->left = merge(a, b->left);
+            update(b);
+            return b;
+        }
+    }
+
+    // cartesian tree over the nodes' priorities in O(n)
+    auto build(std::span<Node* const> nodes) -> Node* {
+        ptr_vector stack(m_alloc);
+        for (auto n : nodes) {
+            n->left = n->right = n->parent = nullptr;
+            Node* last                     = nullptr;
+            while (! stack.empty() && stack.back()->priority < n->priority) {
+                last = stack.back();
+                stack.pop_back();
+            }
+            n->left = last;
+            if (! stack.empty()) stack.back()->right = n;
+            stack.push_back(n);
+        }
+        if (stack.empty()) return nullptr;
+        auto root = stack.front();
+        fix_sizes(root);
+        return root;
+    }
+
+    static auto fix_sizes(Node* n) -> usize {
+        if (! n) return 0;
+        fix_sizes(n->left);
+        fix_sizes(n->right);
+        update(n);
+        return n->size;
+    }
+
+    template<typename F>
+    void free_tree(Node* n, F&& on_erase) {
+        if (! n) return;
+        free_tree(n->left, on_erase);
+        free_tree(n->right, on_erase);
+        on_erase(n);
+        node_traits::destroy(m_alloc, n);
+        // the node is gone, its storage holds the free list link instead
+        m_free = ::new (static_cast<void*>(n)) FreeNode { m_free };
+    }
+
+    static auto storage_of(FreeNode* f) -> Node* {
+        return static_cast<Node*>(static_cast<void*>(f));
+    }
+
+    auto random() noexcept -> std::uint32_t {
+        // xorshift32
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    node_allocator m_alloc;
+    Node*          m_root;
+    FreeNode*      m_free;
+    std::uint32_t  m_seed;
+};
+
+} // namespace kstore::detail
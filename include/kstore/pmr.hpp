@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory_resource>
+
+#include "kstore/share_store.hpp"
+#include "kstore/qt/meta_list_model.hpp"
+
+///
+/// @brief Aliases using std::pmr::polymorphic_allocator
+/// @details Constructors taking an Allocator accept a std::pmr::memory_resource* directly.
+namespace kstore::pmr
+{
+
+template<typename T>
+using allocator = std::pmr::polymorphic_allocator<T>;
+
+template<typename T, typename TItemExtend = void, typename InnerCustom = std::int64_t,
+         StoreMapType MapType = StoreMapType::Node>
+using ShareStore = kstore::ShareStore<T, allocator<T>, TItemExtend, InnerCustom, MapType>;
+
+template<typename TItem, typename IMPL, ListStoreType Store = ListStoreType::Vector>
+using QMetaListModelCRTP =
+    kstore::QMetaListModelCRTP<TItem, IMPL, Store,
+                               allocator<detail::allocator_value_type<TItem, Store>>>;
+
+} // namespace kstore::pmr
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QJsonObject>
@@ -23,12 +25,26 @@ public:
         // must use static member func here, as virtual ptr is not inited here
         if (auto meta = oper->T::rawItemMeta()) {
             updateRoleNames(*meta, this, opts);
+            if (opts & CacheMethod) connectMethodCache();
         }
     }
     explicit QGadgetListModel(QListInterface* oper, QObject* parent = nullptr);
 
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    ///
+    /// @brief Fill every requested role of a row, the row is resolved once
+    void multiData(const QModelIndex& index, QModelRoleDataSpan roleDataSpan) const override;
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+
+    void rowsWritten(usize first, usize last) const override;
+
+private:
+    auto readRole(void* gadget, int row, int role) const -> QVariant;
+    void connectMethodCache();
+    void dropMethodCache(int first, int last) const;
+
+    // row -> (role, result) of its method roles, rows shifting clears it
+    mutable std::unordered_map<int, std::vector<std::pair<int, QVariant>>> m_method_cache;
 };
 
 } // namespace kstore
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <QtCore/QIODevice>
+#include <QtCore/QJsonValue>
+#include "kstore/qt/meta_utils.hpp"
+#include "kstore/item_trait.hpp"
+
+namespace kstore
+{
+
+///
+/// @brief Splits a top-level JSON array into its elements as bytes arrive
+/// @details
+/// Only the element being scanned is buffered, bytes of returned elements are dropped on the
+/// next feed. Elements are not validated here, parse() does that per element.
+class QJsonArrayReader {
+public:
+    QJsonArrayReader();
+
+    void feed(QByteArrayView chunk);
+    ///
+    /// @brief Next complete element, valid until the next feed
+    auto next() -> std::optional<QByteArrayView>;
+
+    ///
+    /// @brief The closing bracket was read
+    auto done() const -> bool;
+    auto hasError() const -> bool;
+
+    static auto parse(QByteArrayView element) -> std::optional<QJsonValue>;
+
+private:
+    enum class State
+    {
+        Start,
+        Elements,
+        Done,
+        Error
+    };
+
+    QByteArray m_buf;
+    qsizetype  m_pos;
+    qsizetype  m_start;
+    int        m_depth;
+    State      m_state;
+    bool       m_in_string;
+    bool       m_escape;
+    bool       m_after_comma;
+};
+
+///
+/// @brief Decode a streamed JSON array into TItem and hand it over in batches
+/// @details
+/// Each element is decoded on its own through qvariant_from_josn, so at most one element's
+/// bytes and batch_size items are alive at a time. Elements that do not decode into TItem
+/// are skipped and counted.
+template<typename TItem>
+class QJsonArrayIngest {
+public:
+    // called with a full batch, or the rest on finish(), it may move the items out
+    using sink_type = std::function<void(std::vector<TItem>&)>;
+
+    QJsonArrayIngest(usize batch_size, sink_type sink)
+        : m_batch_size(std::max<usize>(batch_size, 1)),
+          m_sink(std::move(sink)),
+          m_count(0),
+          m_skipped(0) {
+        m_batch.reserve(m_batch_size);
+    }
+
+    ///
+    /// @return false once the input is not a JSON array
+    auto feed(QByteArrayView chunk) -> bool {
+        m_reader.feed(chunk);
+        while (auto element = m_reader.next()) {
+            auto value = QJsonArrayReader::parse(*element);
+            auto item  = value ? qvariant_from_josn<TItem>(*value) : std::nullopt;
+            if (! item) {
+                ++m_skipped;
+                continue;
+            }
+            m_batch.push_back(std::move(*item));
+            ++m_count;
+            if (m_batch.size() >= m_batch_size) flush();
+        }
+        return ! m_reader.hasError();
+    }
+
+    ///
+    /// @brief Feed what the device has now, in chunks of chunk_size
+    auto read(QIODevice& device, qint64 chunk_size = 64 * 1024) -> bool {
+        while (! device.atEnd()) {
+            auto bytes = device.read(chunk_size);
+            if (bytes.isEmpty()) break;
+            if (! feed(bytes)) return false;
+        }
+        return ! m_reader.hasError();
+    }
+
+    ///
+    /// @brief Hand over the last partial batch
+    /// @return false if the array was malformed or not closed
+    auto finish() -> bool {
+        flush();
+        return m_reader.done();
+    }
+
+    auto count() const -> usize { return m_count; }
+    auto skipped() const -> usize { return m_skipped; }
+
+private:
+    void flush() {
+        if (m_batch.empty()) return;
+        m_sink(m_batch);
+        m_batch.clear();
+    }
+
+    QJsonArrayReader   m_reader;
+    usize              m_batch_size;
+    sink_type          m_sink;
+    std::vector<TItem> m_batch;
+    usize              m_count;
+    usize              m_skipped;
+};
+
+///
+/// @brief Sink appending each batch to a list model with one insert
+template<typename M>
+auto json_model_sink(M& model) {
+    return [&model](auto& batch) {
+        model.insert(model.size(), std::move(batch));
+    };
+}
+
+///
+/// @brief Sink loading each batch into a ShareStore with store_load
+/// @details
+/// No reference is added. With retention on, only the newest items within its budget stay in
+/// the store, hold them with store_item or a list before they are evicted.
+template<typename Store>
+auto json_store_sink(Store& store) {
+    return [&store](auto& batch) {
+        store.store_load(batch);
+    };
+}
+
+} // namespace kstore
@@ -5,10 +5,20 @@
 #    define __cplusplus 202002
 #endif
 
+#include <chrono>
+#include <memory>
+#include <numeric>
+
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFuture>
+#include <QtCore/QPromise>
+#include <QtCore/QTimer>
 #include "kstore/qt/meta_role.hpp"
 #include "kstore/item_trait.hpp"
+#include "kstore/item_diff.hpp"
 #include "kstore/list_impl.hpp"
+#include "kstore/scratch_arena.hpp"
 
 namespace kstore
 {
@@ -17,14 +27,18 @@ class QListInterface {
 public:
     using value_t = void*;
 
-    virtual auto rawAt(qint32 index) const -> value_t               = 0;
-    virtual void rawAssign(qint32 index, const QVariant&)           = 0;
-    virtual auto rawToVariant(value_t) const -> QVariant            = 0;
-    virtual void rawInsert(qint32 index, std::span<const QVariant>) = 0;
-    virtual void rawMove(qint32 src, qint32 dst, qint32 count = 1)  = 0;
-    virtual auto rawItemMeta() const -> QMetaObject const*          = 0;
-    virtual auto rawSize() const -> std::size_t                     = 0;
-    virtual void rawErase(qint32 start, qint32 end)                 = 0;
+    virtual auto rawAt(qint32 index) const -> value_t                       = 0;
+    ///
+    /// @brief Edit the item of a row, func returns whether it changed anything
+    /// @return false if nothing was written
+    virtual bool rawUpdate(qint32 index, const std::function<bool(value_t)>&) = 0;
+    virtual void rawAssign(qint32 index, const QVariant&)                   = 0;
+    virtual auto rawToVariant(value_t) const -> QVariant                    = 0;
+    virtual void rawInsert(qint32 index, std::span<const QVariant>)         = 0;
+    virtual void rawMove(qint32 src, qint32 dst, qint32 count = 1)          = 0;
+    virtual auto rawItemMeta() const -> QMetaObject const*                  = 0;
+    virtual auto rawSize() const -> std::size_t                             = 0;
+    virtual void rawErase(qint32 start, qint32 end)                         = 0;
 };
 
 template<typename TItem, typename IMPL, ListStoreType Store = ListStoreType::Vector,
@@ -46,6 +60,8 @@ public:
     Q_INVOKABLE QVariant     item(qint32 index) const;
     Q_INVOKABLE void         setItem(qint32 index, const QVariant&);
     Q_INVOKABLE QVariantList items(qint32 offset = 0, qint32 n = -1) const;
+    // one insert for all items, keys must not be in the list yet
+    Q_INVOKABLE bool insertItems(qint32 row, const QVariantList& items);
     // Q_INVOKABLE bool move(qint32 src, qint32 dst, qint32 count = 1);
 
     auto hasMore() const -> bool;
@@ -84,7 +100,11 @@ public:
     using rebind_alloc = detail::rebind_alloc<allocator_type, T>;
     using value_type   = TItem;
 
-    QMetaListModelCRTP(Allocator allc = Allocator()): list_impl_t(allc) {};
+    // items per insert inside an async step
+    static constexpr usize async_chunk = 256;
+
+    QMetaListModelCRTP(Allocator allc = Allocator())
+        : list_impl_t(allc), m_sync_move_ratio(0.1), m_async_budget(8) {};
     QMetaListModelCRTP(const QMetaListModelCRTP&) = delete;
 
     virtual ~QMetaListModelCRTP() {};
@@ -95,9 +115,14 @@ public:
         // as item in container is not const
         return const_cast<TItem*>(&(_cimpl().at(index)));
     }
+    bool rawUpdate(qint32 index, const std::function<bool(value_t)>& func) override {
+        return update(index, [&func](TItem& item) {
+            return func(std::addressof(item));
+        });
+    }
     void rawAssign(qint32 index, const QVariant& val) override {
         if (val.canConvert<TItem>()) {
-            _cimpl().at(index) = val.value<TItem>();
+            assign(index, val.value<TItem>());
         }
     }
     auto rawToVariant(value_t p) const -> QVariant override {
@@ -154,27 +179,44 @@ public:
         _cimpl().removeRows(index, size);
     }
 
+    // a Virtual list would run func on placeholders and request every block
     template<typename Func>
+        requires(Store != ListStoreType::Virtual)
     void remove_if(Func&& func) {
-        std::set<int, std::greater<>> indexes;
-        const auto                    n = _cimpl().size();
-        for (int i = 0; i < n; i++) {
-            auto& el = _cimpl().at(i);
-            if (func(el)) {
-                indexes.insert(i);
-            }
-        }
-        for (auto& i : indexes) {
-            this->removeRow(i);
+        auto                                      scratch = m_scratch.scope();
+        std::vector<usize, rebind_scratch<usize>> rows(scratch.allocator());
+        const usize                               n = _cimpl().size();
+        for (usize i = 0; i < n; i++) {
+            if (func(std::as_const(_cimpl()).at(i))) rows.push_back(i);
         }
+        _remove_rows(rows);
     }
     void replace(int row, param_type<TItem> val) {
-        auto& item = _cimpl().at(row);
-        item       = val;
-        auto idx   = _cimpl().index(row);
+        assign(row, val);
+        auto idx = _cimpl().index(row);
         _cimpl().dataChanged(idx, idx);
     }
 
+    ///
+    /// @brief Edit the item of a row, func(TItem&) returns whether it changed anything
+    /// @details Over a snapshot store the edit is written back to the store, every list
+    /// over it sees the change. Emits nothing, the caller signals the rows it changed.
+    template<typename Func>
+    bool update(usize row, Func&& func) {
+        if constexpr (requires { _cimpl()._update_impl(row, func); }) {
+            return _cimpl()._update_impl(row, std::forward<Func>(func));
+        } else {
+            return func(_cimpl().at(row));
+        }
+    }
+    template<typename T>
+    void assign(usize row, T&& val) {
+        update(row, [&val](TItem& item) {
+            item = std::forward<T>(val);
+            return true;
+        });
+    }
+
     void resetModel() {
         _cimpl().beginResetModel();
         _cimpl()._reset_impl();
@@ -202,19 +244,28 @@ public:
         _cimpl().endResetModel();
     }
     template<typename T>
-        requires std::ranges::sized_range<T>
+        requires std::ranges::sized_range<T> && (Store != ListStoreType::Virtual)
     void replaceResetModel(const T& items) {
         const auto  size = items.size();
-        const usize old  = std::max(_cimpl().size(), 0);
+        const usize old  = _cimpl().size();
         const auto  num  = std::min<int>(old, size);
-        for (auto i = 0; i < num; i++) {
-            _cimpl().at(i) = items[i];
+        {
+            auto scratch = m_scratch.scope();
+            std::vector<std::pair<usize, change_mask>,
+                        rebind_scratch<std::pair<usize, change_mask>>>
+                changed(scratch.allocator());
+            for (auto i = 0; i < num; i++) {
+                // every row is written, the mask only picks the rows and roles to signal
+                auto mask = item_diff(std::as_const(_cimpl()).at(i), items[i]);
+                assign(i, items[i]);
+                changed.emplace_back(i, mask);
+            }
+            detail::emit_changed_runs(&_cimpl(), changed);
         }
-        if (num > 0) _cimpl().dataChanged(_cimpl().index(0), _cimpl().index(num));
         if (size > old) {
             insert(num, std::ranges::subrange(items.begin() + num, items.end(), size - num));
         } else if (size < old) {
-            removeRows(size, old - size);
+            _cimpl().removeRows(size, old - size);
         }
     }
 
@@ -223,97 +274,175 @@ public:
         return _cimpl().moveRows(p, sourceRow, count, p, destinationRow);
     }
 
+    ///
+    /// @brief Reset a Virtual list to total placeholder rows, blocks load when read
+    void reset_virtual(usize total)
+        requires(Store == ListStoreType::Virtual)
+    {
+        _cimpl().beginResetModel();
+        _cimpl()._resize_impl(total);
+        _cimpl().endResetModel();
+    }
+
+    ///
+    /// @brief Time an async step may take before yielding to the event loop
+    void set_async_budget(std::chrono::milliseconds budget) { m_async_budget = budget; }
+    auto async_budget() const -> std::chrono::milliseconds { return m_async_budget; }
+
+    ///
+    /// @brief Insert in chunks across event loop turns
+    /// @details
+    /// Each turn inserts async_chunk items at a time until the budget is spent. The model is
+    /// consistent between turns. A later async call cancels this one, rows inserted so far
+    /// stay. Other edits meanwhile shift the rows still pending.
+    /// @return finished when all items are in, canceled if replaced
+    template<typename T>
+        requires std::ranges::sized_range<T>
+    auto insert_async(int index, T&& range) -> QFuture<void> {
+        auto job = _async_begin();
+        job->items.assign(std::ranges::begin(range), std::ranges::end(range));
+        job->runs.push_back({ (usize)index, 0, job->items.size() });
+        return _async_start(job);
+    }
+
+    ///
+    /// @brief Reset to empty now, then insert items as insert_async
+    template<typename T>
+        requires std::ranges::sized_range<T>
+    auto reset_async(T&& items) -> QFuture<void> {
+        auto job = _async_begin();
+        resetModel();
+        job->items.assign(std::ranges::begin(items), std::ranges::end(items));
+        job->runs.push_back({ 0, 0, job->items.size() });
+        return _async_start(job);
+    }
+
+    ///
+    /// @brief sync, with new items inserted as insert_async
+    /// @details
+    /// Removals, moves and updates of existing rows happen now. New items follow in target
+    /// order, so each lands at its final row.
+    template<detail::syncable_list<TItem> U>
+        requires(Store != ListStoreType::Vector && Store != ListStoreType::Virtual)
+    auto sync_async(U&& items) -> QFuture<void> {
+        auto                                    job = _async_begin();
+        std::vector<TItem, rebind_alloc<TItem>> existing(this->get_allocator());
+        for (usize i = 0; i < (usize)items.size(); i++) {
+            if (_cimpl().contains(items[i])) {
+                existing.push_back(items[i]);
+                continue;
+            }
+            auto& runs = job->runs;
+            if (runs.empty() || runs.back().row + (runs.back().last - runs.back().first) != i) {
+                runs.push_back({ i, job->items.size(), job->items.size() });
+            }
+            job->items.push_back(items[i]);
+            runs.back().last++;
+        }
+        sync(existing);
+        return _async_start(job);
+    }
+
+    ///
+    /// @brief Cancel the in-flight async operation, rows applied so far stay
+    void cancel_async() {
+        if (! m_async) return;
+        auto future = m_async->promise.future();
+        future.cancel();
+        m_async->promise.finish();
+        m_async.reset();
+    }
+
+    ///
+    /// @brief Reordering in sync moves rows while moves stay within ratio of the rows
+    /// @details Above it one layoutChanged is emitted instead. 0 always uses layoutChanged.
+    void set_sync_move_ratio(double ratio) { m_sync_move_ratio = ratio; }
+    auto sync_move_ratio() const -> double { return m_sync_move_ratio; }
+
     ///
     /// @brief sync items without reset
     /// if mostly changed, use reset
     template<detail::syncable_list<TItem> U>
+        requires(Store != ListStoreType::Virtual)
     void sync(U&& items) {
         using key_type     = ItemTrait<TItem>::key_type;
-        using idx_map_type = detail::HashMap<key_type, usize, allocator_type>;
+        using idx_map_type = detail::HashMap<key_type, usize, scratch_allocator>;
+        using idx_vec      = std::vector<usize, rebind_scratch<usize>>;
+        using changed_vec  = std::vector<std::pair<usize, change_mask>,
+                                         rebind_scratch<std::pair<usize, change_mask>>>;
         auto self          = &_cimpl();
-
-        auto changed = [self](int row, int count = 1) {
-            if (count < 1) return;
-            auto first = self->index(row);
-            auto last  = count > 1 ? self->index(row + count - 1) : first;
-            self->dataChanged(first, last);
-        };
+        // temporaries below are released together when the scope ends
+        auto scratch = m_scratch.scope();
+        auto alloc   = scratch.allocator();
 
         if constexpr (Store == ListStoreType::Vector) {
             // get key to idx map
-            idx_map_type key_to_idx(self->get_allocator());
+            idx_map_type key_to_idx(alloc);
             key_to_idx.reserve(items.size());
             for (decltype(items.size()) i = 0; i < items.size(); ++i) {
                 key_to_idx.insert({ ItemTrait<TItem>::key(items[i]), i });
             }
 
-            // update existing, collect removals
-            std::vector<usize> to_remove;
+            // update existing, signal those that differ, collect removals
+            idx_vec     to_remove(alloc);
+            changed_vec changed_rows(alloc);
             for (usize i = 0; i < self->size(); i++) {
-                auto key = ItemTrait<TItem>::key(self->at(i));
+                auto& item = self->at(i);
+                auto  key  = ItemTrait<TItem>::key(item);
                 if (auto it = key_to_idx.find(key); it != key_to_idx.end()) {
-                    self->at(i) = std::forward<U>(items)[it->second];
+                    auto mask = item_diff(item, items[it->second]);
+                    item      = std::forward<U>(items)[it->second];
+                    // rows before the removals below, shifted once they are done
+                    changed_rows.emplace_back(i, mask);
                     key_to_idx.erase(it);
                 } else {
                     to_remove.push_back(i);
                 }
             }
 
-            // batch remove back to front
-            for (auto it = to_remove.rbegin(); it != to_remove.rend();) {
-                usize last  = *it;
-                usize first = last;
-                ++it;
-                while (it != to_remove.rend() && *it == first - 1) {
-                    first = *it;
-                    ++it;
-                }
-                self->remove(first, last - first + 1);
-            }
+            _remove_rows(to_remove);
 
-            if (self->size() > 0) changed(0, self->size());
+            // shift by the removed rows before each
+            auto removed = to_remove.begin();
+            for (auto& [row, mask] : changed_rows) {
+                while (removed != to_remove.end() && *removed < row) ++removed;
+                row -= removed - to_remove.begin();
+            }
+            detail::emit_changed_runs(self, changed_rows);
         } else if constexpr (Store == ListStoreType::Map || Store == ListStoreType::Share ||
-                             Store == ListStoreType::VectorWithMap) {
+                             Store == ListStoreType::VectorWithMap ||
+                             Store == ListStoreType::Tree) {
             auto item_size = (usize)items.size();
 
             // build new key set
-            idx_map_type new_key_to_idx(self->get_allocator());
+            idx_map_type new_key_to_idx(alloc);
             new_key_to_idx.reserve(item_size);
             for (usize i = 0; i < item_size; i++) {
                 new_key_to_idx.insert({ ItemTrait<TItem>::key(items[i]), i });
             }
 
             // build old key set (before any modifications)
-            idx_map_type old_key_to_idx(self->get_allocator());
+            idx_map_type old_key_to_idx(alloc);
+            old_key_to_idx.reserve(self->size());
             for (usize i = 0; i < (usize)self->size(); i++) {
                 old_key_to_idx.insert({ self->key_at(i), i });
             }
 
             // ── Phase 1: batch remove items not in new list ──
             {
-                std::vector<usize> to_remove;
+                idx_vec to_remove(alloc);
                 for (usize i = 0; i < (usize)self->size(); i++) {
                     if (! new_key_to_idx.contains(self->key_at(i))) {
                         to_remove.push_back(i);
                     }
                 }
-                for (auto it = to_remove.rbegin(); it != to_remove.rend();) {
-                    usize last  = *it;
-                    usize first = last;
-                    ++it;
-                    while (it != to_remove.rend() && *it == first - 1) {
-                        first = *it;
-                        ++it;
-                    }
-                    self->remove(first, last - first + 1);
-                }
+                _remove_rows(to_remove);
             }
 
-            // ── Phase 2: reorder existing items via layoutChanged ──
+            // ── Phase 2: reorder existing items, by moves or layoutChanged ──
             {
-                using key_vec =
-                    std::vector<key_type, rebind_alloc<key_type>>;
-                key_vec target_order(self->get_allocator());
+                using key_vec = std::vector<key_type, rebind_scratch<key_type>>;
+                key_vec target_order(alloc);
                 target_order.reserve(self->size());
                 for (usize i = 0; i < item_size; i++) {
                     auto key = ItemTrait<TItem>::key(items[i]);
@@ -330,9 +459,59 @@ public:
                     }
                 }
 
+                // fewest moves keep a longest increasing run of old rows in place
+                usize                                   moves = 0;
+                std::vector<bool, rebind_scratch<bool>> keep(alloc);
+                idx_vec                                 old_pos(alloc);
                 if (needs_reorder) {
+                    old_pos.reserve(target_order.size());
+                    for (auto& key : target_order) {
+                        old_pos.push_back(old_key_to_idx.at(key));
+                    }
+                    moves = target_order.size() - detail::mark_lis(old_pos, keep, alloc);
+                }
+
+                if (moves > 0 && moves <= m_sync_move_ratio * target_order.size()) {
+                    // place each moved key right after its predecessor in the target.
+                    // Rows are tracked here since every move invalidates the row index:
+                    // slot 0 is the front and slot r + 1 holds row r after phase 1. A moved
+                    // key joins the run trailing its predecessor's slot, so each slot
+                    // weighs its own row, until that moves away, plus its run.
+                    const usize n = target_order.size();
+                    idx_vec     slot(n, 0, alloc);
+                    {
+                        idx_vec order(n, 0, alloc);
+                        std::iota(order.begin(), order.end(), usize(0));
+                        std::ranges::sort(order, {}, [&old_pos](usize i) {
+                            return old_pos[i];
+                        });
+                        for (usize r = 0; r < n; r++) slot[order[r]] = r + 1;
+                    }
+
+                    detail::PrefixSum<decltype(alloc)> weight(n + 1, alloc);
+                    for (usize s = 1; s <= n; s++) weight.add(s, 1);
+                    idx_vec run(n, 0, alloc);
+                    for (usize i = 0; i < n; i++) {
+                        if (keep[i]) continue;
+                        usize src = weight.prefix(slot[i]);
+                        usize at = 0, dst = 0;
+                        if (i > 0) {
+                            // kept rows never move, a moved predecessor already sits in a run
+                            at  = slot[i - 1];
+                            dst = weight.prefix(at) + 1;
+                            if (! keep[i - 1]) {
+                                run[i] = run[i - 1] + 1;
+                                dst += run[i - 1] + (at > 0 ? 1 : 0);
+                            }
+                        }
+                        if (src != dst && src + 1 != dst) self->move(src, dst, 1);
+                        weight.sub(slot[i], 1);
+                        weight.add(at, 1);
+                        slot[i] = at;
+                    }
+                } else if (moves > 0) {
                     // build key -> new position BEFORE reorder
-                    idx_map_type key_to_new_pos(self->get_allocator());
+                    idx_map_type key_to_new_pos(alloc);
                     for (usize i = 0; i < target_order.size(); i++) {
                         key_to_new_pos[target_order[i]] = i;
                     }
@@ -364,15 +543,19 @@ public:
                 }
             }
 
-            // ── Phase 3: update data for existing items ──
+            // ── Phase 3: update data of existing items, signal those that differ ──
             {
+                changed_vec changed_rows(alloc);
                 for (usize i = 0; i < (usize)self->size(); i++) {
                     auto key = self->key_at(i);
                     if (auto it = new_key_to_idx.find(key); it != new_key_to_idx.end()) {
-                        self->at(i) = std::forward<U>(items)[it->second];
+                        // every row is written, the mask only picks what to signal
+                        auto mask = item_diff(std::as_const(*self).at(i), items[it->second]);
+                        assign(i, std::forward<U>(items)[it->second]);
+                        changed_rows.emplace_back(i, mask);
                     }
                 }
-                if (self->size() > 0) changed(0, self->size());
+                detail::emit_changed_runs(self, changed_rows);
             }
 
             // ── Phase 4: insert new items ──
@@ -392,7 +575,7 @@ public:
                                    ItemTrait<TItem>::key(items[i]))) {
                             i++;
                         }
-                        std::vector<TItem> batch;
+                        std::vector<TItem, rebind_scratch<TItem>> batch(alloc);
                         batch.reserve(i - batch_start);
                         for (usize j = batch_start; j < i; j++) {
                             batch.push_back(std::forward<U>(items)[j]);
@@ -410,14 +593,16 @@ public:
     /// if mostly changed, use reset
     /// @return increased size
     template<detail::syncable_list<TItem> U>
+        requires(Store != ListStoreType::Virtual)
     auto extend(U&& items) -> usize {
         using key_type     = ItemTrait<TItem>::key_type;
-        using idx_set_type = detail::Set<usize, allocator_type>;
-        using idx_map_type = detail::HashMap<key_type, usize, allocator_type>;
+        using idx_map_type = detail::HashMap<key_type, usize, scratch_allocator>;
         auto self          = &_cimpl();
+        auto scratch       = m_scratch.scope();
+        auto alloc         = scratch.allocator();
 
         // get key to idx map
-        idx_map_type key_to_idx(self->get_allocator());
+        idx_map_type key_to_idx(alloc);
         key_to_idx.reserve(items.size());
         for (decltype(items.size()) i = 0; i < items.size(); ++i) {
             key_to_idx.insert({ ItemTrait<TItem>::key(items[i]), i });
@@ -445,30 +630,118 @@ public:
                     key_to_idx.erase(it);
                 }
             }
-        } else if constexpr (Store == ListStoreType::Map || Store == ListStoreType::Share) {
+        } else if constexpr (Store == ListStoreType::Map || Store == ListStoreType::Share ||
+                             Store == ListStoreType::Tree) {
             for (usize i = 0; i < self->size(); ++i) {
                 auto h = self->key_at(i);
                 if (auto it = key_to_idx.find(h); it != key_to_idx.end()) {
-                    self->at(i) = std::forward<U>(items)[it->second];
+                    assign(i, std::forward<U>(items)[it->second]);
                     changed(i);
                     key_to_idx.erase(it);
                 }
             }
         }
 
-        // append new
-        idx_set_type ids(self->get_allocator());
+        // append new in input order, as one insert
+        std::vector<usize, rebind_scratch<usize>> ids(alloc);
+        ids.reserve(key_to_idx.size());
         for (auto& el : key_to_idx) {
-            ids.insert(el.second);
+            ids.push_back(el.second);
         }
+        std::ranges::sort(ids);
+        std::vector<TItem, rebind_scratch<TItem>> batch(alloc);
+        batch.reserve(ids.size());
         for (auto id : ids) {
-            self->insert(self->size(), std::forward<U>(items)[id]);
+            batch.push_back(std::forward<U>(items)[id]);
         }
-        return ids.size();
+        return self->insert(self->size(), std::move(batch));
     }
 
 private:
+    using scratch_allocator = detail::ScratchArena::allocator_type;
+    template<typename T>
+    using rebind_scratch = detail::rebind_alloc<scratch_allocator, T>;
+
+    struct AsyncApply {
+        // insert items[first, last) at row
+        struct Run {
+            usize row;
+            usize first;
+            usize last;
+        };
+
+        AsyncApply(const Allocator& alloc): items(alloc), runs(alloc), next(0) {}
+
+        QPromise<void>                          promise;
+        std::vector<TItem, rebind_alloc<TItem>> items;
+        std::vector<Run, rebind_alloc<Run>>     runs;
+        usize                                   next;
+    };
+
+    auto _async_begin() -> std::shared_ptr<AsyncApply> {
+        cancel_async();
+        m_async = std::make_shared<AsyncApply>(this->get_allocator());
+        m_async->promise.start();
+        return m_async;
+    }
+
+    auto _async_start(const std::shared_ptr<AsyncApply>& job) -> QFuture<void> {
+        auto future = job->promise.future();
+        // the first step runs now, the rest is scheduled
+        _async_step(job);
+        return future;
+    }
+
+    void _async_step(std::shared_ptr<AsyncApply> job) {
+        // canceled or replaced
+        if (job != m_async) return;
+
+        QElapsedTimer timer;
+        timer.start();
+        auto& runs = job->runs;
+        while (job->next < runs.size()) {
+            auto& run   = runs[job->next];
+            auto  begin = job->items.begin() + run.first;
+            auto  end   = job->items.begin() + std::min(run.first + async_chunk, run.last);
+            run.row += insert(run.row, std::ranges::subrange(begin, end));
+            run.first += end - begin;
+            if (run.first == run.last) ++job->next;
+            if (timer.elapsed() >= m_async_budget.count()) break;
+        }
+
+        if (job->next == runs.size()) {
+            job->promise.finish();
+            m_async.reset();
+            return;
+        }
+        QTimer::singleShot(0, &_cimpl(), [this, job] {
+            _async_step(job);
+        });
+    }
+
+    ///
+    /// @brief Remove rows back to front, one removeRows per run of adjacent rows
+    /// @param sorted ascending, without duplicates
+    template<typename R>
+    void _remove_rows(const R& sorted) {
+        for (auto it = std::ranges::rbegin(sorted); it != std::ranges::rend(sorted);) {
+            usize last  = *it;
+            usize first = last;
+            ++it;
+            while (it != std::ranges::rend(sorted) && *it == first - 1) {
+                first = *it;
+                ++it;
+            }
+            _cimpl().remove(first, last - first + 1);
+        }
+    }
+
     auto&       _cimpl() noexcept { return *static_cast<IMPL*>(this); }
     const auto& _cimpl() const noexcept { return *static_cast<const IMPL*>(this); }
+
+    detail::ScratchArena        m_scratch;
+    double                      m_sync_move_ratio;
+    std::chrono::milliseconds   m_async_budget;
+    std::shared_ptr<AsyncApply> m_async;
 };
 } // namespace kstore
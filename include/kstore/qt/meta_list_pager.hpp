@@ -0,0 +1,127 @@
+#pragma once
+
+#include <optional>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include "kstore/qt/meta_list_model.hpp"
+
+namespace kstore
+{
+
+///
+/// @brief Requests pages of a QMetaListModel ahead of the visible range
+/// @details
+/// Pages are appended at the end of the model, one in flight at a time. reqPage is emitted
+/// once the visible range comes within prefetchDistance rows of the end, or when the view
+/// calls fetchMore. A response is matched by its id, a canceled or stale one is dropped.
+class QMetaListPager : public QObject {
+    Q_OBJECT
+
+    Q_PROPERTY(kstore::QMetaListModel* model READ model WRITE setModel NOTIFY modelChanged FINAL)
+    Q_PROPERTY(qint32 pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged FINAL)
+    Q_PROPERTY(qint32 prefetchDistance READ prefetchDistance WRITE setPrefetchDistance NOTIFY
+                   prefetchDistanceChanged FINAL)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged FINAL)
+public:
+    struct Stats {
+        // pages requested, canceled, and responses dropped as stale
+        usize  requests { 0 };
+        usize  canceled { 0 };
+        usize  stale { 0 };
+        // pages landed before the view reached them, and pages the view waited for
+        usize  hits { 0 };
+        usize  misses { 0 };
+        // request to response, of accepted pages
+        qint64 last_latency_ms { 0 };
+        qint64 total_latency_ms { 0 };
+    };
+
+    QMetaListPager(QObject* parent = nullptr);
+    ~QMetaListPager();
+
+    auto          model() const -> QMetaListModel*;
+    void          setModel(QMetaListModel*);
+    Q_SIGNAL void modelChanged();
+
+    auto          pageSize() const -> qint32;
+    void          setPageSize(qint32);
+    Q_SIGNAL void pageSizeChanged();
+
+    auto          prefetchDistance() const -> qint32;
+    void          setPrefetchDistance(qint32);
+    Q_SIGNAL void prefetchDistanceChanged();
+
+    auto          loading() const -> bool;
+    Q_SIGNAL void loadingChanged();
+
+    auto stats() const -> const Stats&;
+
+    ///
+    /// @brief Report the rows the view shows, last inclusive
+    Q_INVOKABLE void setVisibleRange(qint32 first, qint32 last);
+
+    ///
+    /// @brief Drop the page in flight, its response will be ignored
+    Q_INVOKABLE void cancel();
+
+    ///
+    /// @brief Cancel and expect pages from the start again
+    Q_INVOKABLE void reset();
+
+    ///
+    /// @brief Ingest a response as one insert at the end of the model
+    /// @param hasMore false after the last page
+    /// @return false when the page was canceled or is stale, nothing is inserted
+    Q_INVOKABLE bool pageLoaded(qint32 id, const QVariantList& items, bool hasMore);
+
+    ///
+    /// @brief Typed pageLoaded, model is the CRTP model behind model()
+    template<typename M, typename R>
+        requires std::ranges::sized_range<R>
+    bool pageLoaded(qint32 id, M& model, R&& items, bool hasMore) {
+        if (! acceptPage(id)) return false;
+        model.insert(model.size(), std::forward<R>(items));
+        pageDone(hasMore);
+        return true;
+    }
+
+    ///
+    /// @brief Match a response to the page in flight and record its latency
+    auto acceptPage(qint32 id) -> bool;
+    ///
+    /// @brief After the page's rows are inserted, may request the next page
+    void pageDone(bool hasMore);
+
+    ///
+    /// @brief Load rows [offset, offset + count) and answer with pageLoaded(id, ...)
+    Q_SIGNAL void reqPage(qint32 id, qint32 offset, qint32 count);
+    Q_SIGNAL void pageCanceled(qint32 id);
+
+private:
+    Q_SLOT void onFetchMore();
+    void        request();
+    void        maybeRequest();
+    void        wait();
+    void        clearInflight();
+
+    struct Page {
+        qint32        id;
+        qint32        offset;
+        bool          waited;
+        QElapsedTimer timer;
+    };
+
+    QPointer<QMetaListModel> m_model;
+    qint32                   m_page_size;
+    qint32                   m_prefetch;
+    qint32                   m_next_id;
+    qint32                   m_last_visible;
+    bool                     m_has_more;
+    std::optional<Page>      m_inflight;
+    Stats                    m_stats;
+    QMetaObject::Connection  m_fetch_connection;
+    QMetaObject::Connection  m_reset_connection;
+};
+
+} // namespace kstore
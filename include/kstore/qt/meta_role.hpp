@@ -5,6 +5,7 @@
 #include <QtCore/QMetaProperty>
 #include <QtCore/QMetaMethod>
 #include <QtCore/QAbstractItemModel>
+#include "kstore/item_trait.hpp"
 
 namespace kstore
 {
@@ -16,13 +17,25 @@ struct QEmpty {
 class QMetaRoleNames {
 public:
     QMetaRoleNames();
+    virtual ~QMetaRoleNames();
 
     auto meta() const -> const QMetaObject&;
     auto roleOf(QByteArrayView name) const -> int;
+    ///
+    /// @brief Roles affected by a change mask, empty for all roles
+    /// @details Method roles are included whenever any property changed.
+    auto rolesOfMask(change_mask mask) const -> QList<int>;
+    ///
+    /// @brief Items of rows first to last were written, signalled or not
+    /// @details A write with a change mask of 0 emits no dataChanged, a model that keeps
+    /// results per row drops them here. Does nothing by default.
+    virtual void rowsWritten(usize first, usize last) const;
 
     enum Option
     {
         WithMethod = 1,
+        /// keep method role results per row until the row changes, needs WithMethod
+        CacheMethod = 2,
     };
     auto options() const -> int;
 
@@ -32,6 +45,17 @@ public:
         bool       is_method;
     };
 
+    ///
+    /// @brief Reads a property role through the moc generated static_metacall
+    /// @details No QMetaProperty is built, the value is read straight into the returned QVariant.
+    struct RoleAccessor {
+        QMetaObject::Data::StaticMetacallFunction call;
+        int                                       index;
+        QMetaType                                 type;
+
+        auto read(const void* gadget) const -> QVariant;
+    };
+
 protected:
     void updateRoleNames(const QMetaObject& meta, QAbstractItemModel* model, int opts);
     auto roleNamesRef() const -> const QHash<int, QByteArray>&;
@@ -39,12 +63,23 @@ protected:
     auto nameRolesRef() const -> const QHash<QByteArray, int>&;
     auto propertyOfRole(int role) const -> std::optional<QMetaProperty>;
     auto methodOfRole(int role) const -> std::optional<QMetaMethod>;
+    ///
+    /// @brief Accessor of a property role, indexed by role without a hash lookup
+    /// @return nullptr for method roles, unknown roles, and properties moc gives no reader
+    auto accessorOfRole(int role) const -> const RoleAccessor* {
+        const auto idx = role - Qt::UserRole - 1;
+        if (idx < 0 || idx >= m_role_accessors.size()) return nullptr;
+        auto& out = m_role_accessors[idx];
+        return out.call ? &out : nullptr;
+    }
 
 private:
     QHash<int, RoleInfo>   m_role_infos;
     QHash<int, QByteArray> m_role_names;
     QHash<QByteArray, int> m_name_roles;
-    QMetaObject            m_meta;
+    // by role - Qt::UserRole - 1
+    QList<RoleAccessor> m_role_accessors;
+    QMetaObject         m_meta;
     int                    m_opts;
 };
 
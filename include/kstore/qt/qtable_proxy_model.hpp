@@ -22,6 +22,7 @@ public:
     void setSourceModel(QAbstractItemModel* sourceModel) override;
 
     auto data(const QModelIndex& proxyIndex, int role = Qt::DisplayRole) const -> QVariant override;
+    void multiData(const QModelIndex& proxyIndex, QModelRoleDataSpan roleDataSpan) const override;
     auto headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const
         -> QVariant override;
     auto roleNames() const -> QHash<int, QByteArray> override;
@@ -34,18 +35,21 @@ public:
 private:
     Q_SLOT void syncColumns();
 
-    Q_SLOT void sourceDataChanged();
-    Q_SLOT void sourceHeaderDataChanged();
-    Q_SLOT void sourceRowsAboutToBeInserted();
-    Q_SLOT void sourceRowsInserted();
+    Q_SLOT void sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight,
+                                  const QList<int>& roles);
+    Q_SLOT void sourceHeaderDataChanged(Qt::Orientation orientation, int first, int last);
+    Q_SLOT void sourceRowsAboutToBeInserted(const QModelIndex& parent, int first, int last);
+    Q_SLOT void sourceRowsInserted(const QModelIndex& parent);
     Q_SLOT void sourceColumnsAboutToBeInserted();
     Q_SLOT void sourceColumnsInserted();
-    Q_SLOT void sourceRowsAboutToBeRemoved();
-    Q_SLOT void sourceRowsRemoved();
+    Q_SLOT void sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    Q_SLOT void sourceRowsRemoved(const QModelIndex& parent);
     Q_SLOT void sourceColumnsAboutToBeRemoved();
     Q_SLOT void sourceColumnsRemoved();
-    Q_SLOT void sourceRowsAboutToBeMoved();
-    Q_SLOT void sourceRowsMoved();
+    Q_SLOT void sourceRowsAboutToBeMoved(const QModelIndex& sourceParent, int sourceStart,
+                                         int sourceEnd, const QModelIndex& destinationParent,
+                                         int destinationRow);
+    Q_SLOT void sourceRowsMoved(const QModelIndex& sourceParent);
     Q_SLOT void sourceColumnsAboutToBeMoved();
     Q_SLOT void sourceColumnsMoved();
     Q_SLOT void sourceLayoutAboutToBeChanged(const QList<QPersistentModelIndex>&  sourceParents,
@@ -57,11 +61,17 @@ private:
     struct HeaderData {
         int     role;
         QString propname;
+
+        bool operator==(const HeaderData&) const = default;
     };
     std::vector<HeaderData> m_headers;
     QHash<int, QByteArray>  m_rolenames;
     QStringList             m_column_names;
 
+    // persistent indexes across a source layout change, with the source rows they follow
+    QModelIndexList              m_layout_proxy;
+    QList<QPersistentModelIndex> m_layout_source;
+
     std::array<QMetaObject::Connection, 18> m_source_connections;
 };
 
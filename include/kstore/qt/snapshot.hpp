@@ -0,0 +1,247 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMetaProperty>
+#include <QtCore/QSaveFile>
+#include "kstore/share_store.hpp"
+
+namespace kstore
+{
+
+///
+/// @brief Properties kept by a snapshot
+/// @details Stored, readable and writable ones whose type is not a pointer and has data
+/// stream operators.
+auto snapshot_properties(const QMetaObject&) -> QList<QMetaProperty>;
+///
+/// @brief Stable hash of the class name, the kept properties' names and types, and the key type
+auto snapshot_schema_hash(const QMetaObject&, QMetaType key) -> quint64;
+void snapshot_write_gadget(QDataStream&, const QList<QMetaProperty>&, const void* gadget);
+///
+/// @return false if the stream failed before every property was read
+auto snapshot_read_gadget(QDataStream&, const QList<QMetaProperty>&, void* gadget) -> bool;
+
+///
+/// @brief Binary snapshot of a ShareStore's items and the key order of lists over it
+/// @details
+/// The file is one QDataStream, written in a single pass:
+///   header  magic, version, schema hash, item count, list count, index offset
+///   items   the kept properties of each item, back to back
+///   index   key and offset of each item, then each list as name, count and keys
+/// open() maps the file and reads the header and index only. It rejects another version or
+/// schema. An item is decoded from the mapping when query() or items() first asks for it.
+/// Keys are written with QDataStream, so key_type needs its stream operators.
+template<typename T>
+class QStoreSnapshot {
+public:
+    using key_type = ItemTrait<T>::key_type;
+
+    static constexpr quint32 magic   = 0x4b534e50; // KSNP
+    static constexpr quint32 version = 1;
+
+    struct List {
+        QString               name;
+        std::vector<key_type> keys;
+    };
+
+    QStoreSnapshot(): m_data(nullptr) {}
+    ~QStoreSnapshot() { close(); }
+    QStoreSnapshot(const QStoreSnapshot&)            = delete;
+    QStoreSnapshot& operator=(const QStoreSnapshot&) = delete;
+
+    static auto schema() -> quint64 {
+        static const auto hash =
+            snapshot_schema_hash(T::staticMetaObject, QMetaType::fromType<key_type>());
+        return hash;
+    }
+
+    ///
+    /// @brief Key order of a list model, by key_at
+    template<typename M>
+    static auto list_of(QString name, const M& model) -> List {
+        List out { std::move(name), {} };
+        out.keys.reserve(model.size());
+        for (usize i = 0; i < (usize)model.size(); i++) out.keys.push_back(model.key_at(i));
+        return out;
+    }
+
+    ///
+    /// @brief Write every item of the store, retained ones included, and the lists
+    /// @details Goes through QSaveFile, an existing snapshot is replaced only on success.
+    template<typename Store>
+    static bool write(const QString& path, const Store& store, std::span<const List> lists = {}) {
+        QSaveFile file(path);
+        if (! file.open(QIODevice::WriteOnly)) return false;
+        QDataStream s(&file);
+        s.setVersion(QDataStream::Qt_6_0);
+
+        auto& map = store.inner->map;
+        s << magic << version << schema() << quint32(map.size()) << quint32(lists.size());
+        const auto index_pos = file.pos();
+        s << quint64(0);
+
+        std::vector<std::pair<key_type, quint64>> offsets;
+        offsets.reserve(map.size());
+        for (auto& [key, idx] : map) {
+            offsets.emplace_back(key, file.pos());
+            snapshot_write_gadget(s, properties(), std::addressof(store.inner->slots[idx].item));
+        }
+
+        const quint64 index = file.pos();
+        for (auto& [key, offset] : offsets) s << key << offset;
+        for (auto& list : lists) {
+            s << list.name << quint32(list.keys.size());
+            for (auto& key : list.keys) s << key;
+        }
+        if (! file.seek(index_pos)) return false;
+        s << index;
+        return s.status() == QDataStream::Ok && file.commit();
+    }
+
+    ///
+    /// @brief Map a snapshot, false if it is missing, truncated or of another schema
+    bool open(const QString& path) {
+        close();
+        m_file.setFileName(path);
+        if (! m_file.open(QIODevice::ReadOnly)) return false;
+        const auto size = m_file.size();
+        m_data          = m_file.map(0, size);
+        if (! m_data) {
+            close();
+            return false;
+        }
+        m_bytes  = QByteArray::fromRawData(reinterpret_cast<const char*>(m_data), size);
+        m_stream = std::make_unique<QDataStream>(m_bytes);
+        m_stream->setVersion(QDataStream::Qt_6_0);
+
+        auto&   s = *m_stream;
+        quint32 file_magic, file_version, items, lists;
+        quint64 file_schema, index;
+        s >> file_magic >> file_version >> file_schema >> items >> lists >> index;
+        if (s.status() != QDataStream::Ok || file_magic != magic || file_version != version ||
+            file_schema != schema() || index > (quint64)size || ! s.device()->seek(index)) {
+            close();
+            return false;
+        }
+
+        m_offsets.reserve(items);
+        for (quint32 i = 0; i < items; i++) {
+            key_type key;
+            quint64  offset;
+            s >> key >> offset;
+            m_offsets.insert({ key, offset });
+        }
+        for (quint32 i = 0; i < lists; i++) {
+            QString name;
+            quint32 n;
+            s >> name >> n;
+            auto& keys = m_lists[name];
+            keys.reserve(std::min<quint32>(n, items));
+            for (quint32 j = 0; j < n && s.status() == QDataStream::Ok; j++) {
+                key_type key;
+                s >> key;
+                keys.push_back(key);
+            }
+        }
+        if (s.status() != QDataStream::Ok) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        m_stream.reset();
+        m_bytes.clear();
+        if (m_data) m_file.unmap(m_data);
+        m_data = nullptr;
+        m_file.close();
+        m_offsets.clear();
+        m_lists.clear();
+    }
+
+    auto is_open() const -> bool { return m_data != nullptr; }
+    auto size() const -> usize { return m_offsets.size(); }
+    auto contains(param_type<key_type> key) const -> bool { return m_offsets.contains(key); }
+    auto list_names() const -> QList<QString> { return m_lists.keys(); }
+
+    ///
+    /// @return empty if there is no such list
+    auto keys(const QString& name) const -> std::span<const key_type> {
+        if (auto it = m_lists.constFind(name); it != m_lists.cend()) return *it;
+        return {};
+    }
+
+    ///
+    /// @brief Decode one item from the mapping
+    auto query(param_type<key_type> key) const -> std::optional<T> {
+        if (auto it = m_offsets.find(key); it != m_offsets.end()) return decode(it->second);
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief Decode the items of a list in its order, ready for a list model's resetModel
+    /// @details Items that fail to decode are left out.
+    auto items(const QString& name) const -> std::vector<T> {
+        std::vector<T> out;
+        auto           list = keys(name);
+        out.reserve(list.size());
+        for (auto& key : list) {
+            if (auto it = m_offsets.find(key); it != m_offsets.end()) {
+                if (auto item = decode(it->second)) out.push_back(std::move(*item));
+            }
+        }
+        return out;
+    }
+
+    ///
+    /// @brief Decode every item into the store with ShareStore::store_load
+    /// @return the number of items loaded, items that fail to decode are left out
+    /// @details
+    /// No reference is added. With retention on, the items are retained rather than held, so
+    /// only the newest within its budget are still in the store afterwards.
+    template<typename Store>
+    auto restore(Store& store) const -> usize {
+        std::vector<T> all;
+        all.reserve(m_offsets.size());
+        for (auto& [key, offset] : m_offsets) {
+            if (auto item = decode(offset)) all.push_back(std::move(*item));
+        }
+        store.store_load(all);
+        return all.size();
+    }
+
+private:
+    static auto properties() -> const QList<QMetaProperty>& {
+        static const auto props = snapshot_properties(T::staticMetaObject);
+        return props;
+    }
+
+    auto decode(quint64 offset) const -> std::optional<T> {
+        T out {};
+        if (m_stream->device()->seek(offset) &&
+            snapshot_read_gadget(*m_stream, properties(), std::addressof(out))) {
+            return out;
+        }
+        // a failed read leaves the status set for every later decode
+        m_stream->resetStatus();
+        return std::nullopt;
+    }
+
+    QFile                                 m_file;
+    uchar*                                m_data;
+    QByteArray                            m_bytes;
+    std::unique_ptr<QDataStream>          m_stream;
+    std::unordered_map<key_type, quint64> m_offsets;
+    QHash<QString, std::vector<key_type>> m_lists;
+};
+
+} // namespace kstore
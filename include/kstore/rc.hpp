@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 
 namespace kstore
 {
@@ -8,23 +9,22 @@ template<typename T>
 class Rc {
 public:
     Rc(): m_inner(nullptr) {}
-    ~Rc() {
-        if (m_inner) {
-            if (m_inner->decrease() == 0) {
-                delete m_inner;
-            }
-        }
+    ~Rc() { release(); }
+    Rc(const Rc& o) noexcept: m_inner(o.m_inner) {
+        if (m_inner) m_inner->increase();
     }
-    Rc(const Rc& o) noexcept: m_inner(o.m_inner) { m_inner->increase(); }
-    Rc(Rc& o) noexcept: m_inner(o.m_inner) { o.m_inner = nullptr; }
+    Rc(Rc&& o) noexcept: m_inner(std::exchange(o.m_inner, nullptr)) {}
     Rc& operator=(const Rc& o) noexcept {
+        if (o.m_inner) o.m_inner->increase();
+        release();
         m_inner = o.m_inner;
-        m_inner->increase();
         return *this;
     }
-    Rc& operator=(Rc& o) noexcept {
-        m_inner   = o.m_inner;
-        o.m_inner = nullptr;
+    Rc& operator=(Rc&& o) noexcept {
+        if (this != &o) {
+            release();
+            m_inner = std::exchange(o.m_inner, nullptr);
+        }
         return *this;
     }
 
@@ -48,6 +48,15 @@ private:
             return count;
         }
     };
+
+    void release() noexcept {
+        if (m_inner && m_inner->decrease() == 0) {
+            delete m_inner->ptr;
+            delete m_inner;
+        }
+        m_inner = nullptr;
+    }
+
     Inner* m_inner;
 };
-} // namespace kstore
\ No newline at end of file
+} // namespace kstore
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "kstore/item_trait.hpp"
+
+namespace kstore::detail
+{
+
+///
+/// @brief Reusable memory for per-call temporaries
+/// @details
+/// Each Scope hands out a monotonic resource over one retained buffer and drops everything
+/// at once when it ends. Memory that did not fit is taken from upstream and the buffer grows
+/// to that high-water mark afterwards, so repeated calls of the same size stay off upstream.
+/// Not thread safe, a nested scope draws from the outer one.
+class ScratchArena {
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        CountingResource(std::pmr::memory_resource* upstream): upstream(upstream), bytes(0) {}
+
+        std::pmr::memory_resource* upstream;
+        usize                      bytes;
+
+    private:
+        void* do_allocate(usize n, usize align) override {
+            bytes += n;
+            return upstream->allocate(n, align);
+        }
+        void do_deallocate(void* p, usize n, usize align) override {
+            upstream->deallocate(p, n, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+            return this == &o;
+        }
+    };
+
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    class Scope {
+    public:
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            m_mono.release();
+            if (m_outer) return;
+            m_arena.m_active = nullptr;
+            if (m_counting.bytes > 0) m_arena.grow(m_arena.m_capacity + m_counting.bytes);
+        }
+
+        auto resource() noexcept -> std::pmr::memory_resource* { return &m_mono; }
+        auto allocator() noexcept -> allocator_type { return &m_mono; }
+
+    private:
+        friend class ScratchArena;
+        explicit Scope(ScratchArena& arena, std::pmr::memory_resource* outer)
+            : m_arena(arena),
+              m_outer(outer),
+              m_counting(arena.m_upstream),
+              m_mono(outer ? nullptr : arena.m_buffer, outer ? 0 : arena.m_capacity,
+                     outer ? outer : &m_counting) {
+            if (! outer) m_arena.m_active = &m_mono;
+        }
+
+        ScratchArena&                       m_arena;
+        std::pmr::memory_resource*          m_outer;
+        CountingResource                    m_counting;
+        std::pmr::monotonic_buffer_resource m_mono;
+    };
+
+    explicit ScratchArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream), m_buffer(nullptr), m_capacity(0), m_active(nullptr) {}
+    ~ScratchArena() {
+        if (m_buffer) m_upstream->deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+    }
+    ScratchArena(const ScratchArena&)            = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    auto scope() -> Scope { return Scope { *this, m_active }; }
+
+    auto capacity() const noexcept -> usize { return m_capacity; }
+
+private:
+    void grow(usize n) {
+        if (m_buffer) m_upstream->deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+        m_buffer   = m_upstream->allocate(n, alignof(std::max_align_t));
+        m_capacity = n;
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    void*                      m_buffer;
+    usize                      m_capacity;
+    std::pmr::memory_resource* m_active;
+};
+
+} // namespace kstore::detail
@@ -1,22 +1,66 @@
 #pragma once
 
+#include <algorithm>
 #include <span>
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
+#include <ranges>
+#include <unordered_map>
+#include <vector>
 
 #include "kstore/item_trait.hpp"
-#include "kstore/rc.hpp"
+#include "kstore/item_diff.hpp"
+#include "kstore/flat_map.hpp"
+#include "kstore/arc.hpp"
+#include "kstore/slot_arena.hpp"
 
 namespace kstore
 {
 
+///
+/// @brief Backend of ShareStore::Inner::map, the key to slot index
+/// @details Items live in a slot arena either way, item pointers stay valid until removed.
+enum class StoreMapType
+{
+    /// std::unordered_map
+    Node = 0,
+    /// FlatHashMap
+    Flat
+};
+
+namespace detail
+{
+template<StoreMapType, typename K, typename V, typename Allocator>
+struct store_map_helper;
+
+template<typename K, typename V, typename Allocator>
+struct store_map_helper<StoreMapType::Node, K, V, Allocator> {
+    using type = std::unordered_map<
+        K, V, std::hash<K>, std::equal_to<K>,
+        typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const K, V>>>;
+};
+
+template<typename K, typename V, typename Allocator>
+struct store_map_helper<StoreMapType::Flat, K, V, Allocator> {
+    using type = FlatHashMap<
+        K, V, std::hash<K>, std::equal_to<K>,
+        typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const K, V>>>;
+};
+
+template<StoreMapType M, typename K, typename V, typename Allocator>
+using store_map_t = typename store_map_helper<M, K, V, Allocator>::type;
+} // namespace detail
+
 ///
 /// @brief store_type
+/// @details store_query gives either a pointer into the store or a shared snapshot of the item.
 template<typename T, typename TItem>
 concept storeable =
     requires(T t, TItem item, typename ItemTrait<TItem>::key_type key, std::int64_t handle) {
-        { t.store_query(key) } -> std::same_as<TItem*>;
+        requires std::same_as<decltype(t.store_query(key)), TItem*> ||
+                     std::same_as<decltype(t.store_query(key)), std::shared_ptr<const TItem>>;
         t.store_insert(item);
         t.store_remove(key);
         // {
@@ -32,34 +76,78 @@ template<typename T>
 concept storeable_item = hashable_item<T> && requires(T t) { typename ItemTrait<T>::store_type; } &&
                          storeable<typename ItemTrait<T>::store_type, T>;
 
+///
+/// @brief Per-item result of ShareStore::store_upsert_many
+enum class UpsertResult : std::uint8_t
+{
+    Updated = 0,
+    Inserted,
+    /// existed and item_diff found no change, notified with a mask of 0
+    Unchanged
+};
+
+///
+/// @brief Counters of the ShareStore retention cache
+struct StoreStats {
+    /// retained entries revived by store_item, store_increase or an insert
+    std::uint64_t hits { 0 };
+    /// store_item calls that found nothing
+    std::uint64_t misses { 0 };
+    /// retained entries dropped to stay in budget
+    std::uint64_t evictions { 0 };
+    /// current retained entries and their bytes
+    usize retained { 0 };
+    usize retained_bytes { 0 };
+};
+
 template<typename T, typename Allocator = std::allocator<T>, typename TItemExtend = void,
-         typename InnerCustom = std::int64_t>
+         typename InnerCustom = std::int64_t, StoreMapType MapType = StoreMapType::Node>
 struct ShareStore;
 
+template<typename T, usize Shards = 16, typename Allocator = std::allocator<T>>
+struct ConcurrentShareStore;
+
 template<typename T, typename Store>
 class StoreItem {
     using key_type = typename kstore::ItemTrait<T>::key_type;
-    template<typename, typename Allocator, typename TItemExtend, typename InnerCustom>
+    template<typename, typename Allocator, typename TItemExtend, typename InnerCustom,
+             StoreMapType>
     friend struct ShareStore;
+    template<typename, usize, typename>
+    friend struct ConcurrentShareStore;
 
-    StoreItem(Store s, key_type k): m_store(s), m_key(k) { Q_ASSERT(m_key); }
+    StoreItem(Store s, key_type k, StoreSlot slot): m_store(s), m_key(k), m_slot(slot) {
+        Q_ASSERT(m_key);
+    }
 
 public:
     StoreItem() = delete;
     StoreItem(Store s): m_store(s) {}
 
-    StoreItem(const StoreItem& o): m_store(o.m_store), m_key(o.m_key) { increase(); }
-    StoreItem(StoreItem&& o) noexcept: m_store(o.m_store), m_key(o.m_key) { o.m_key = {}; }
-    StoreItem& operator=(const StoreItem& o) {
-        m_store = o.m_store;
-        m_key   = o.m_key;
+    StoreItem(const StoreItem& o): m_store(o.m_store), m_key(o.m_key), m_slot(o.m_slot) {
         increase();
+    }
+    StoreItem(StoreItem&& o) noexcept: m_store(o.m_store), m_key(o.m_key), m_slot(o.m_slot) {
+        o.m_key = {};
+    }
+    StoreItem& operator=(const StoreItem& o) {
+        if (this != &o) {
+            release();
+            m_store = o.m_store;
+            m_key   = o.m_key;
+            m_slot  = o.m_slot;
+            increase();
+        }
         return *this;
     }
     StoreItem& operator=(StoreItem&& o) noexcept {
-        m_store = o.m_store;
-        m_key   = o.m_key;
-        o.m_key = {};
+        if (this != &o) {
+            release();
+            m_store = o.m_store;
+            m_key   = o.m_key;
+            m_slot  = o.m_slot;
+            o.m_key = {};
+        }
         return *this;
     }
 
@@ -67,16 +155,23 @@ public:
         return m_key == o.m_key && m_store == o.m_store;
     }
 
-    ~StoreItem() {
-        if (m_key) m_store.store_remove(*m_key);
-    }
+    ~StoreItem() { release(); }
 
-    auto item() const -> T* { return store_query(); }
-    auto operator*() const -> T& { return *store_query(); }
-    auto operator->() const -> T* { return *store_query(); }
-         operator bool() const { return store_query() != nullptr; }
+    // T*, or a shared snapshot for stores that hand out snapshots
+    auto item() const { return store_query(); }
+    auto operator->() const { return store_query(); }
+    // a snapshot is copied out, it is not kept alive by the handle
+    decltype(auto) operator*() const {
+        if constexpr (std::is_pointer_v<decltype(store_query())>) {
+            return *store_query();
+        } else {
+            return T(*store_query());
+        }
+    }
+    operator bool() const { return store_query() != nullptr; }
 
     auto key() const { return m_key; }
+    auto slot() const { return m_slot; }
     auto store() const { return m_store; }
 
     // increase ref count, careful to call this
@@ -85,22 +180,31 @@ public:
     }
 
 private:
-    auto store_query() const -> T* {
+    auto store_query() const {
+        using pointer = decltype(m_store.store_at(m_slot));
         if (m_key) {
-            return m_store.store_query(*m_key);
+            // the slot resolves without hashing, the key keeps it alive
+            return m_store.store_at(m_slot);
         }
-        return nullptr;
+        return pointer {};
+    }
+    void release() {
+        if (m_key) m_store.store_remove(*m_key);
+        m_key = {};
     }
 
     Store                   m_store;
     std::optional<key_type> m_key;
+    StoreSlot               m_slot;
 };
 
-template<typename T, typename Allocator, typename TItemExtend, typename InnerCustom>
+template<typename T, typename Allocator, typename TItemExtend, typename InnerCustom,
+         StoreMapType MapType>
 struct ShareStore {
     using handle_type     = std::int64_t;
     using key_type        = typename ItemTrait<T>::key_type;
-    using callback_type   = std::function<void(std::span<const key_type>)>;
+    using callback_type =
+        std::function<void(std::span<const key_type>, std::span<const change_mask>)>;
     using store_item_type = StoreItem<T, ShareStore>;
     using item_type       = T;
 
@@ -115,6 +219,10 @@ struct ShareStore {
         handle_type count;
         auto        increase() noexcept { return ++count; }
         auto        decrease() noexcept { return --count; }
+
+        // retention list links, only used while count is 0
+        std::uint32_t lru_prev { detail::slot_npos };
+        std::uint32_t lru_next { detail::slot_npos };
     };
 
     struct _ItemEx {
@@ -129,115 +237,455 @@ struct ShareStore {
 
         auto increase() noexcept { return ++count; }
         auto decrease() noexcept { return --count; }
+
+        std::uint32_t lru_prev { detail::slot_npos };
+        std::uint32_t lru_next { detail::slot_npos };
     };
 
     using inner_item_type = std::conditional_t<std::same_as<void, TItemExtend>, _Item, _ItemEx>;
 
+    using callback_map = std::map<handle_type, callback_type, std::less<>,
+                                  rebind_alloc<std::pair<const handle_type, callback_type>>>;
+    using handle_list  = std::vector<handle_type, rebind_alloc<handle_type>>;
+
     struct Inner {
-        Inner(Allocator alloc): map(alloc), callbacks(alloc), serial(0) {}
+        Inner(Allocator alloc)
+            : map(alloc), slots(alloc), callbacks(alloc), routed(alloc), interest(alloc), serial(0) {}
         ~Inner() {}
 
-        std::unordered_map<key_type, inner_item_type, std::hash<key_type>, std::equal_to<key_type>,
-                           rebind_alloc<std::pair<const key_type, inner_item_type>>>
-            map;
-        std::map<handle_type, callback_type, std::less<>,
-                 rebind_alloc<std::pair<const handle_type, callback_type>>>
-                    callbacks;
-        handle_type serial;
+        // key -> index in slots
+        detail::store_map_t<MapType, key_type, std::uint32_t, Allocator> map;
+        detail::SlotArena<inner_item_type, Allocator>                    slots;
+        callback_map                                                     callbacks;
+        // routed callbacks and the keys each one subscribed to
+        callback_map                                                     routed;
+        detail::store_map_t<MapType, key_type, handle_list, Allocator>   interest;
+        handle_type                                                      serial;
+
+        // zero-ref entries, head is the most recently released
+        struct Retention {
+            usize         max_entries { 0 };
+            usize         max_bytes { 0 };
+            std::uint32_t head { detail::slot_npos };
+            std::uint32_t tail { detail::slot_npos };
+            StoreStats    stats;
+
+            bool enabled() const noexcept { return max_entries > 0 || max_bytes > 0; }
+        } retention;
 
         InnerCustom custom;
     };
 
-    Rc<Inner> inner;
+    Arc<Inner> inner;
 
-    ShareStore(Allocator alloc = Allocator {}): inner(Rc<Inner>::create(new Inner(alloc))) {}
+    ///
+    /// @brief Non-owning store handle
+    /// @details Forwards to the store while it is alive, behaves as an empty store after.
+    struct WeakStore {
+        Weak<Inner> inner;
+
+        auto lock() const -> std::optional<ShareStore> {
+            if (auto arc = inner.lock()) return ShareStore { std::move(arc) };
+            return std::nullopt;
+        }
+        auto store_query(param_type<key_type> k) const -> T* {
+            if (auto s = lock()) return s->store_query(k);
+            return nullptr;
+        }
+        auto store_at(StoreSlot slot) const -> T* {
+            if (auto s = lock()) return s->store_at(slot);
+            return nullptr;
+        }
+        void store_increase(param_type<key_type> k) {
+            if (auto s = lock()) s->store_increase(k);
+        }
+        void store_remove(param_type<key_type> k) {
+            if (auto s = lock()) s->store_remove(k);
+        }
+        constexpr bool operator==(const WeakStore& o) const { return inner == o.inner; }
+    };
+    using weak_store_type      = WeakStore;
+    using weak_store_item_type = StoreItem<T, WeakStore>;
+
+    ShareStore(Allocator alloc = Allocator {}): inner(Arc<Inner>::make(alloc)) {}
+    explicit ShareStore(Arc<Inner> inner): inner(std::move(inner)) {}
 
     constexpr bool operator==(const ShareStore& o) const { return inner == o.inner; }
 
+    auto downgrade() const -> WeakStore { return { inner.downgrade() }; }
+
     Allocator get_allocator() { return inner->map.get_allocator(); }
 
     auto store_query(param_type<key_type> k) const -> T* {
-        auto it = inner->map.find(k);
-        if (it != inner->map.end()) {
-            return std::addressof(it->second.item);
+        if (auto e = entry(k)) return std::addressof(e->item);
+        return nullptr;
+    }
+
+    ///
+    /// @brief Slot of a key, to be resolved later with store_at
+    auto store_slot(param_type<key_type> k) const -> std::optional<StoreSlot> {
+        if (auto it = inner->map.find(k); it != inner->map.end()) {
+            return inner->slots.handle(it->second);
         }
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief Item of a slot without hashing
+    /// @return nullptr if the item of that slot was removed
+    auto store_at(StoreSlot slot) const -> T* {
+        if (auto e = inner->slots.get(slot)) return std::addressof(e->item);
         return nullptr;
     }
 
-    template<typename Range>
-    void store_changed_callback(const Range& range, std::int64_t ignore_handle = 0) {
+    ///
+    /// @param masks changed fields of each key, see item_diff
+    template<typename Range, std::ranges::range MaskRange>
+    void store_changed_callback(const Range& range, const MaskRange& masks,
+                                std::int64_t ignore_handle = 0) {
         for (auto& el : inner->callbacks) {
             if (el.first == ignore_handle) continue;
-            el.second(range);
+            el.second(range, masks);
         }
+        if (! inner->routed.empty()) route_changed(range, masks, ignore_handle);
+    }
+
+    template<typename Range>
+    void store_changed_callback(const Range& range, std::int64_t ignore_handle = 0) {
+        std::vector<change_mask, rebind_alloc<change_mask>> masks(
+            std::ranges::size(range), change_mask_all, get_allocator());
+        store_changed_callback(range, masks, ignore_handle);
     }
 
     auto store_insert(param_type<T> item) -> std::pair<store_item_type, bool> {
         bool changed { false };
-        auto key = ItemTrait<T>::key(item);
-        if (auto it = inner->map.find(key); it != inner->map.end()) {
-            it->second.item = item;
+        auto key            = ItemTrait<T>::key(item);
+        auto [it, inserted] = inner->map.try_emplace(key, 0);
+        if (inserted) {
+            it->second = inner->slots.emplace(item, 1 + own_ref()).index;
+        } else {
+            auto& e = inner->slots[it->second];
+            if (e.count == 0) revive(it->second);
+            changed = item_diff<T>(e.item, item) != 0;
+            e.item  = item;
             // for store item
-            it->second.increase();
+            e.increase();
+        }
 
-            changed = true;
-        } else {
-            inner->map.insert(std::pair { key, inner_item_type { item, 2 } });
+        return { { *this, key, inner->slots.handle(it->second) }, changed };
+    }
+
+    ///
+    /// @brief Insert or update every item with a single probe each
+    /// @param refs_of called once per item with its key and slot, returns the references to add
+    /// @return UpsertResult per item, in input order
+    /// @details
+    /// Like store_insert, a new item also gets the reference kept by the store.
+    /// With retention on, an item left without references is retained as after store_remove.
+    /// Fires one store_changed_callback with the keys and change masks of existing items.
+    /// Every one is overwritten, so an item that item_diff reports as unchanged is still
+    /// listed, with a mask of 0.
+    template<std::ranges::input_range R, typename RefsOf>
+        requires std::invocable<RefsOf&, param_type<key_type>, StoreSlot>
+    auto store_upsert_many(R&& items, RefsOf&& refs_of, handle_type ignore_handle = 0)
+        -> std::vector<UpsertResult, rebind_alloc<UpsertResult>> {
+        std::vector<UpsertResult, rebind_alloc<UpsertResult>> results(get_allocator());
+        std::vector<key_type, rebind_alloc<key_type>>         updated(get_allocator());
+        std::vector<change_mask, rebind_alloc<change_mask>>   masks(get_allocator());
+        auto&                                                 map   = inner->map;
+        auto&                                                 slots = inner->slots;
+        if constexpr (std::ranges::sized_range<R>) {
+            auto n = std::ranges::size(items);
+            results.reserve(n);
+            map.reserve(map.size() + n);
         }
 
-        return { { *this, key }, changed };
+        for (auto&& el : std::forward<R>(items)) {
+            auto key            = ItemTrait<T>::key(el);
+            auto [it, inserted] = map.try_emplace(key, 0);
+            if (inserted) {
+                it->second = slots.emplace(std::forward<decltype(el)>(el), own_ref()).index;
+                results.push_back(UpsertResult::Inserted);
+            } else {
+                auto& e = slots[it->second];
+                if (e.count == 0) {
+                    revive(it->second);
+                    e.count = own_ref();
+                }
+                auto mask = item_diff<T>(e.item, el);
+                e.item     = std::forward<decltype(el)>(el);
+                results.push_back(mask != 0 ? UpsertResult::Updated : UpsertResult::Unchanged);
+                updated.push_back(key);
+                masks.push_back(mask);
+            }
+            auto idx = it->second;
+            slots[idx].count += static_cast<handle_type>(refs_of(key, slots.handle(idx)));
+            // nothing holds it, as after store_remove
+            if (slots[idx].count == 0) {
+                retain(idx);
+                trim_retained();
+            }
+        }
+
+        if (! updated.empty()) store_changed_callback(updated, masks, ignore_handle);
+        return results;
+    }
+
+    ///
+    /// @brief store_upsert_many that adds one reference per item
+    /// @details The caller owns the added references and releases them with store_remove.
+    template<std::ranges::input_range R>
+    auto store_insert_range(R&& items, handle_type ignore_handle = 0) {
+        return store_upsert_many(
+            std::forward<R>(items),
+            [](param_type<key_type>, StoreSlot) -> handle_type {
+                return 1;
+            },
+            ignore_handle);
     }
 
+    ///
+    /// @brief store_upsert_many that adds no reference, for warming the store before lists use it
+    /// @details
+    /// With retention off, a new item holds only the store's own reference and stays until
+    /// store_remove drops it. With retention on, nothing holds the items: each is retained as
+    /// after store_remove, and the oldest are evicted once over budget, possibly before this
+    /// returns. Use store_insert_range to keep every item resident.
+    template<std::ranges::input_range R>
+    auto store_load(R&& items, handle_type ignore_handle = 0) {
+        return store_upsert_many(
+            std::forward<R>(items),
+            [](param_type<key_type>, StoreSlot) -> handle_type {
+                return 0;
+            },
+            ignore_handle);
+    }
+
+    ///
+    /// @details Also revives a retained entry, see set_retention.
     auto store_item(param_type<key_type> k) -> std::optional<store_item_type> {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
-            it->second.increase();
-            return store_item_type { *this, k };
+            if (inner->slots[it->second].count == 0) revive(it->second);
+            inner->slots[it->second].increase();
+            return store_item_type { *this, k, inner->slots.handle(it->second) };
+        }
+        ++inner->retention.stats.misses;
+        return std::nullopt;
+    }
+
+    ///
+    /// @brief Like store_item, but the handle does not keep the store alive
+    auto store_weak_item(param_type<key_type> k) -> std::optional<weak_store_item_type> {
+        if (auto it = inner->map.find(k); it != inner->map.end()) {
+            if (inner->slots[it->second].count == 0) revive(it->second);
+            inner->slots[it->second].increase();
+            return weak_store_item_type { downgrade(), k, inner->slots.handle(it->second) };
         }
         return std::nullopt;
     }
 
     void store_increase(param_type<key_type> k) {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
-            it->second.increase();
+            if (inner->slots[it->second].count == 0) revive(it->second);
+            inner->slots[it->second].increase();
         }
     }
 
     void store_remove(param_type<key_type> k) {
         if (auto it = inner->map.find(k); it != inner->map.end()) {
-            auto count = it->second.decrease();
-            if (count == 0) inner->map.erase(it);
+            auto idx = it->second;
+            if (inner->slots[idx].count > 0 && inner->slots[idx].decrease() == 0) {
+                if (inner->retention.enabled()) {
+                    retain(idx);
+                    trim_retained();
+                } else {
+                    inner->map.erase(it);
+                    inner->slots.erase(idx);
+                }
+            }
         }
     }
 
+    ///
+    /// @brief Keep entries whose count drops to 0 in an LRU list instead of erasing them
+    /// @param max_entries most retained entries, 0 for no limit
+    /// @param max_bytes most retained bytes by item_byte_size, 0 for no limit
+    /// @details
+    /// Retained entries still answer store_query and come back with store_item or an upsert.
+    /// While enabled the store does not keep a reference of its own to new entries,
+    /// so call this before inserting. Both 0 disables it and drops all retained entries.
+    void set_retention(usize max_entries, usize max_bytes = 0) {
+        inner->retention.max_entries = max_entries;
+        inner->retention.max_bytes   = max_bytes;
+        trim_retained();
+    }
+
+    auto stats() const -> StoreStats { return inner->retention.stats; }
+
     auto store_reg_notify(callback_type cb) -> handle_type {
         auto handle = ++(inner->serial);
         inner->callbacks.insert({ handle, cb });
         return handle;
     }
-    void store_unreg_notify(handle_type handle) { inner->callbacks.erase(handle); }
+    ///
+    /// @brief Register a callback that only takes the written keys
+    template<typename F>
+        requires std::invocable<F&, std::span<const key_type>>
+    auto store_reg_notify(F cb) -> handle_type {
+        return store_reg_notify(callback_type {
+            [cb = std::move(cb)](std::span<const key_type> keys,
+                                 std::span<const change_mask>) mutable {
+                cb(keys);
+            } });
+    }
+    void store_unreg_notify(handle_type handle) {
+        inner->callbacks.erase(handle);
+        inner->routed.erase(handle);
+    }
+
+    ///
+    /// @brief Register a callback that only hears about keys subscribed with store_subscribe
+    /// @details Each call gets the subset of a change that the handle subscribed to, in order.
+    auto store_reg_routed_notify(callback_type cb) -> handle_type {
+        auto handle = ++(inner->serial);
+        inner->routed.insert({ handle, std::move(cb) });
+        return handle;
+    }
+
+    template<std::ranges::input_range R>
+    void store_subscribe(handle_type handle, R&& keys) {
+        for (auto& key : keys) {
+            auto [it, inserted] = inner->interest.try_emplace(key);
+            it->second.push_back(handle);
+        }
+    }
+
+    template<std::ranges::input_range R>
+    void store_unsubscribe(handle_type handle, R&& keys) {
+        for (auto& key : keys) {
+            auto it = inner->interest.find(key);
+            if (it == inner->interest.end()) continue;
+            auto& handles = it->second;
+            if (auto h = std::ranges::find(handles, handle); h != handles.end()) {
+                *h = handles.back();
+                handles.pop_back();
+            }
+            if (handles.empty()) inner->interest.erase(it);
+        }
+    }
 
     // extend
     auto query_extend(kstore::param_type<key_type> key) -> TItemExtend*
         requires(! std::same_as<TItemExtend, void>)
     {
-        auto& map = this->inner->map;
-        if (auto it = map.find(key); it != map.end()) {
-            return std::addressof(it->second.extend);
-        }
+        if (auto e = entry(key)) return std::addressof(e->extend);
         return nullptr;
     }
 
     auto query_extend(kstore::param_type<key_type> key) const -> TItemExtend*
         requires(! std::same_as<TItemExtend, void>)
     {
-        auto& map = this->inner->map;
-        if (auto it = map.find(key); it != map.end()) {
-            return std::addressof(it->second.extend);
-        }
+        if (auto e = entry(key)) return std::addressof(e->extend);
         return nullptr;
     }
 
     auto size() const -> std::size_t { return inner->map.size(); }
+
+private:
+    // one call per subscribed handle, with its keys and masks in change order
+    template<typename Range, typename MaskRange>
+    void route_changed(const Range& range, const MaskRange& masks, handle_type ignore_handle) {
+        std::span<const key_type>    all_keys(range);
+        std::span<const change_mask> all_masks(masks);
+
+        std::vector<std::pair<handle_type, usize>, rebind_alloc<std::pair<handle_type, usize>>>
+            hits(get_allocator());
+        for (usize i = 0; i < all_keys.size(); i++) {
+            auto it = inner->interest.find(all_keys[i]);
+            if (it == inner->interest.end()) continue;
+            for (auto handle : it->second) {
+                if (handle != ignore_handle) hits.emplace_back(handle, i);
+            }
+        }
+        if (hits.empty()) return;
+        std::ranges::sort(hits);
+
+        std::vector<key_type, rebind_alloc<key_type>>       keys(get_allocator());
+        std::vector<change_mask, rebind_alloc<change_mask>> sub_masks(get_allocator());
+        for (auto it = hits.begin(); it != hits.end();) {
+            auto handle = it->first;
+            keys.clear();
+            sub_masks.clear();
+            for (; it != hits.end() && it->first == handle; ++it) {
+                keys.push_back(all_keys[it->second]);
+                sub_masks.push_back(all_masks[it->second]);
+            }
+            // looked up per call, a callback may unregister another
+            if (auto cb = inner->routed.find(handle); cb != inner->routed.end()) {
+                cb->second(keys, sub_masks);
+            }
+        }
+    }
+
+    auto entry(param_type<key_type> k) const -> inner_item_type* {
+        if (auto it = inner->map.find(k); it != inner->map.end()) {
+            return std::addressof(inner->slots[it->second]);
+        }
+        return nullptr;
+    }
+
+    auto own_ref() const -> handle_type { return inner->retention.enabled() ? 0 : 1; }
+
+    void retain(std::uint32_t idx) {
+        auto& r = inner->retention;
+        auto& e = inner->slots[idx];
+        e.lru_prev = detail::slot_npos;
+        e.lru_next = r.head;
+        if (r.head != detail::slot_npos) inner->slots[r.head].lru_prev = idx;
+        r.head = idx;
+        if (r.tail == detail::slot_npos) r.tail = idx;
+        r.stats.retained += 1;
+        r.stats.retained_bytes += item_byte_size(e.item);
+    }
+
+    void unlink_retained(std::uint32_t idx) {
+        auto& r = inner->retention;
+        auto& e = inner->slots[idx];
+        if (e.lru_prev != detail::slot_npos) {
+            inner->slots[e.lru_prev].lru_next = e.lru_next;
+        } else {
+            r.head = e.lru_next;
+        }
+        if (e.lru_next != detail::slot_npos) {
+            inner->slots[e.lru_next].lru_prev = e.lru_prev;
+        } else {
+            r.tail = e.lru_prev;
+        }
+        e.lru_prev = e.lru_next = detail::slot_npos;
+        r.stats.retained -= 1;
+        r.stats.retained_bytes -= std::min(r.stats.retained_bytes, item_byte_size(e.item));
+    }
+
+    void revive(std::uint32_t idx) {
+        unlink_retained(idx);
+        ++inner->retention.stats.hits;
+    }
+
+    void trim_retained() {
+        auto& r = inner->retention;
+        auto  over = [&r] {
+            if (! r.enabled()) return r.stats.retained > 0;
+            return (r.max_entries > 0 && r.stats.retained > r.max_entries) ||
+                   (r.max_bytes > 0 && r.stats.retained_bytes > r.max_bytes);
+        };
+        while (over()) {
+            auto idx = r.tail;
+            unlink_retained(idx);
+            inner->map.erase(ItemTrait<T>::key(inner->slots[idx].item));
+            inner->slots.erase(idx);
+            ++r.stats.evictions;
+        }
+    }
 };
 
 } // namespace kstore
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace kstore
+{
+
+///
+/// @brief Generational index of an item inside a store
+/// @details A slot is reused after its item is removed, the generation tells the two apart.
+struct StoreSlot {
+    std::uint32_t index { 0 };
+    std::uint32_t generation { 0 };
+
+    constexpr bool operator==(const StoreSlot&) const = default;
+};
+
+namespace detail
+{
+
+inline constexpr std::uint32_t slot_npos = UINT32_MAX;
+
+///
+/// @brief Chunked slot storage with stable addresses and a free list
+/// @details
+/// Values never move once emplaced, chunks are only added.
+/// Generations start at 1, so a default StoreSlot never resolves.
+template<typename V, typename Allocator, std::uint32_t ChunkBits = 8>
+class SlotArena {
+public:
+    static constexpr std::uint32_t chunk_size = std::uint32_t { 1 } << ChunkBits;
+    static constexpr std::uint32_t npos       = slot_npos;
+
+    struct Slot {
+        std::uint32_t    generation { 1 };
+        std::uint32_t    next_free { npos };
+        std::optional<V> value;
+    };
+
+    using slot_allocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using chunk_allocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Slot*>;
+
+    SlotArena(Allocator alloc = Allocator {})
+        : m_alloc(alloc), m_chunks(alloc), m_next(0), m_free(npos), m_size(0) {}
+    ~SlotArena() {
+        for (auto chunk : m_chunks) {
+            std::destroy_n(chunk, chunk_size);
+            m_alloc.deallocate(chunk, chunk_size);
+        }
+    }
+    SlotArena(const SlotArena&)            = delete;
+    SlotArena& operator=(const SlotArena&) = delete;
+
+    template<typename... Args>
+    auto emplace(Args&&... args) -> StoreSlot {
+        std::uint32_t idx;
+        if (m_free != npos) {
+            idx    = m_free;
+            m_free = slot(idx).next_free;
+        } else {
+            if (m_next == m_chunks.size() * chunk_size) grow();
+            idx = m_next++;
+        }
+        auto& s = slot(idx);
+        s.value.emplace(std::forward<Args>(args)...);
+        ++m_size;
+        return { idx, s.generation };
+    }
+
+    void erase(std::uint32_t idx) {
+        auto& s = slot(idx);
+        s.value.reset();
+        // skip 0 on wrap around
+        if (++s.generation == 0) s.generation = 1;
+        s.next_free = m_free;
+        m_free      = idx;
+        --m_size;
+    }
+
+    void clear() {
+        for (std::uint32_t i = 0; i < m_next; i++) {
+            if (slot(i).value) erase(i);
+        }
+    }
+
+    auto get(StoreSlot h) noexcept -> V* {
+        if (h.index >= m_next) return nullptr;
+        auto& s = slot(h.index);
+        return s.generation == h.generation && s.value ? std::addressof(*s.value) : nullptr;
+    }
+    auto get(StoreSlot h) const noexcept -> V const* {
+        return const_cast<SlotArena*>(this)->get(h);
+    }
+
+    // unchecked, idx must be alive
+    auto operator[](std::uint32_t idx) noexcept -> V& { return *slot(idx).value; }
+    auto operator[](std::uint32_t idx) const noexcept -> V const& { return *slot(idx).value; }
+
+    auto handle(std::uint32_t idx) const noexcept -> StoreSlot {
+        return { idx, slot(idx).generation };
+    }
+    auto size() const noexcept -> std::size_t { return m_size; }
+
+private:
+    auto slot(std::uint32_t idx) const noexcept -> Slot& {
+        return m_chunks[idx >> ChunkBits][idx & (chunk_size - 1)];
+    }
+
+    void grow() {
+        auto chunk = m_alloc.allocate(chunk_size);
+        std::uninitialized_default_construct_n(chunk, chunk_size);
+        m_chunks.push_back(chunk);
+    }
+
+    slot_allocator                      m_alloc;
+    std::vector<Slot*, chunk_allocator> m_chunks;
+    std::uint32_t                       m_next;
+    std::uint32_t                       m_free;
+    std::size_t                         m_size;
+};
+
+} // namespace detail
+} // namespace kstore
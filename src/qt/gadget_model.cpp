@@ -9,38 +9,107 @@ auto kstore::readOnGadget(const QVariant& obj, const char* name) -> QVariant {
     return {};
 }
 
+namespace
+{
+// rows cached past this are dropped all at once, views only ask for visible rows
+constexpr std::size_t method_cache_max = 1 << 12;
+
+auto invoke_method(const QMetaMethod& method, void* gadget) -> QVariant {
+    auto     ret_type = method.returnMetaType();
+    QVariant ret { ret_type };
+    // the result is assigned straight into the variant
+    QTemplatedMetaMethodReturnArgument<void> ret_arg = {
+        { .metaType = ret_type.iface(), .name = nullptr, .data = ret.data() }
+    };
+    method.invokeOnGadget(gadget, ret_arg);
+    return ret;
+}
+} // namespace
+
 namespace kstore
 {
 
 QGadgetListModel::QGadgetListModel(QListInterface* oper, QObject* parent)
     : QMetaListModel(oper, parent) {}
+void QGadgetListModel::connectMethodCache() {
+    connect(this,
+            &QAbstractItemModel::dataChanged,
+            this,
+            [this](const QModelIndex& first, const QModelIndex& last) {
+                dropMethodCache(first.row(), last.row());
+            });
+    auto clear = [this] {
+        m_method_cache.clear();
+    };
+    connect(this, &QAbstractItemModel::rowsInserted, this, clear);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, clear);
+    connect(this, &QAbstractItemModel::rowsMoved, this, clear);
+    connect(this, &QAbstractItemModel::layoutChanged, this, clear);
+    connect(this, &QAbstractItemModel::modelReset, this, clear);
+}
 QVariant QGadgetListModel::data(const QModelIndex& index, int role) const {
+    return readRole(m_oper->rawAt(index.row()), index.row(), role);
+}
+void QGadgetListModel::multiData(const QModelIndex& index, QModelRoleDataSpan roleDataSpan) const {
+    const auto row = index.row();
+    if (! index.isValid() || row >= (qint32)m_oper->rawSize()) {
+        for (auto& d : roleDataSpan) d.clearData();
+        return;
+    }
+    auto gadget = m_oper->rawAt(row);
+    for (auto& d : roleDataSpan) {
+        d.setData(readRole(gadget, row, d.role()));
+    }
+}
+auto QGadgetListModel::readRole(void* gadget, int row, int role) const -> QVariant {
+    if (auto accessor = this->accessorOfRole(role)) {
+        return accessor->read(gadget);
+    }
     if (auto prop = this->propertyOfRole(role); prop) {
-        return prop.value().readOnGadget(m_oper->rawAt(index.row()));
+        return prop.value().readOnGadget(gadget);
     }
 
     if (this->options() & kstore::QMetaRoleNames::WithMethod) {
         if (auto method = this->methodOfRole(role); method) {
-            auto ret_type = method->returnMetaType();
-            auto ret_data = ret_type.create();
-
-            QTemplatedMetaMethodReturnArgument<void> ret_arg = {
-                { .metaType = ret_type.iface(), .name = nullptr, .data = ret_data }
-            };
-
-            method.value().invokeOnGadget(m_oper->rawAt(index.row()), ret_arg);
-            QVariant ret { ret_type, ret_data };
-            ret_type.destroy(ret_data);
-            return ret;
+            if (! (this->options() & kstore::QMetaRoleNames::CacheMethod)) {
+                return invoke_method(*method, gadget);
+            }
+            if (auto it = m_method_cache.find(row); it != m_method_cache.end()) {
+                for (auto& [cached_role, value] : it->second) {
+                    if (cached_role == role) return value;
+                }
+            } else if (m_method_cache.size() >= method_cache_max) {
+                m_method_cache.clear();
+            }
+            auto& results = m_method_cache[row];
+            return results.emplace_back(role, invoke_method(*method, gadget)).second;
         }
     }
     return {};
-};
+}
+void QGadgetListModel::dropMethodCache(int first, int last) const {
+    if (m_method_cache.empty()) return;
+    // a changed property may feed any method role of the row
+    if (usize(last - first) >= m_method_cache.size()) {
+        std::erase_if(m_method_cache, [first, last](const auto& el) {
+            return el.first >= first && el.first <= last;
+        });
+    } else {
+        for (auto row = first; row <= last; ++row) m_method_cache.erase(row);
+    }
+}
+void QGadgetListModel::rowsWritten(usize first, usize last) const {
+    if (this->options() & kstore::QMetaRoleNames::CacheMethod) {
+        dropMethodCache(int(first), int(last));
+    }
+}
 bool QGadgetListModel::setData(const QModelIndex& index, const QVariant& value, int role) {
     const auto row = index.row();
     if (row >= 0 && row < (qint32)m_oper->rawSize()) {
         if (auto prop = this->propertyOfRole(role); prop) {
-            bool changed = prop.value().writeOnGadget(m_oper->rawAt(index.row()), value);
+            bool changed = m_oper->rawUpdate(row, [&prop, &value](void* gadget) {
+                return prop.value().writeOnGadget(gadget, value);
+            });
             if (changed) {
                 dataChanged(index, index, { role });
             }
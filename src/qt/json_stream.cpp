@@ -0,0 +1,134 @@
+#include "kstore/qt/json_stream.hpp"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+namespace
+{
+constexpr auto is_space(char c) -> bool {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+} // namespace
+
+namespace kstore
+{
+
+QJsonArrayReader::QJsonArrayReader()
+    : m_pos(0),
+      m_start(-1),
+      m_depth(0),
+      m_state(State::Start),
+      m_in_string(false),
+      m_escape(false),
+      m_after_comma(false) {}
+
+void QJsonArrayReader::feed(QByteArrayView chunk) {
+    // drop what was returned already, the element in progress stays
+    auto keep = m_start >= 0 ? m_start : m_pos;
+    if (keep > 0) {
+        m_buf.remove(0, keep);
+        m_pos -= keep;
+        if (m_start >= 0) m_start -= keep;
+    }
+    m_buf.append(chunk);
+}
+
+auto QJsonArrayReader::next() -> std::optional<QByteArrayView> {
+    const auto size = m_buf.size();
+    const auto data = m_buf.constData();
+    auto       element = [this, data](qsizetype end) {
+        while (end > m_start && is_space(data[end - 1])) --end;
+        auto out = QByteArrayView(data + m_start, end - m_start);
+        m_start  = -1;
+        return out;
+    };
+
+    while (m_pos < size) {
+        const char c = data[m_pos];
+        switch (m_state) {
+        case State::Start:
+            if (c == '[') {
+                m_state = State::Elements;
+            } else if (! is_space(c)) {
+                m_state = State::Error;
+                return std::nullopt;
+            }
+            ++m_pos;
+            break;
+        case State::Elements:
+            if (m_in_string) {
+                if (m_escape) {
+                    m_escape = false;
+                } else if (c == '\\') {
+                    m_escape = true;
+                } else if (c == '"') {
+                    m_in_string = false;
+                }
+                ++m_pos;
+                break;
+            }
+            if (m_start < 0) {
+                if (is_space(c)) {
+                    ++m_pos;
+                    break;
+                }
+                if (c == ']' && ! m_after_comma) {
+                    // empty array
+                    m_state = State::Done;
+                    ++m_pos;
+                    break;
+                }
+                if (c == ']' || c == ',') {
+                    m_state = State::Error;
+                    return std::nullopt;
+                }
+                m_start = m_pos;
+            }
+            if (c == '"') {
+                m_in_string = true;
+            } else if (c == '{' || c == '[') {
+                ++m_depth;
+            } else if ((c == '}' || c == ']') && m_depth > 0) {
+                --m_depth;
+            } else if (c == ']') {
+                m_state = State::Done;
+                return element(m_pos++);
+            } else if (c == ',' && m_depth == 0) {
+                m_after_comma = true;
+                return element(m_pos++);
+            }
+            ++m_pos;
+            break;
+        case State::Done:
+            if (! is_space(c)) {
+                m_state = State::Error;
+                return std::nullopt;
+            }
+            ++m_pos;
+            break;
+        case State::Error: return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+auto QJsonArrayReader::done() const -> bool { return m_state == State::Done; }
+auto QJsonArrayReader::hasError() const -> bool { return m_state == State::Error; }
+
+auto QJsonArrayReader::parse(QByteArrayView element) -> std::optional<QJsonValue> {
+    if (element.empty()) return std::nullopt;
+    QJsonParseError error;
+    if (element.front() == '{' || element.front() == '[') {
+        auto doc = QJsonDocument::fromJson(element.toByteArray(), &error);
+        if (error.error != QJsonParseError::NoError) return std::nullopt;
+        if (doc.isObject()) return doc.object();
+        return doc.array();
+    }
+    // a scalar is only a document inside an array
+    auto doc = QJsonDocument::fromJson("[" + element.toByteArray() + "]", &error);
+    if (error.error != QJsonParseError::NoError) return std::nullopt;
+    return doc.array().at(0);
+}
+
+} // namespace kstore
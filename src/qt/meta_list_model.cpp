@@ -49,6 +49,14 @@ auto QMetaListModel::items(qint32 offset, qint32 n) const -> QVariantList {
     return list;
 }
 
+bool QMetaListModel::insertItems(qint32 row, const QVariantList& items) {
+    if (items.isEmpty() || row < 0 || row > rowCount()) return false;
+    beginInsertRows(QModelIndex(), row, row + items.size() - 1);
+    m_oper->rawInsert(row, items);
+    endInsertRows();
+    return true;
+}
+
 bool QMetaListModel::insertRows(int row, int count, const QModelIndex& parent) {
     const auto cur_count = rowCount(parent);
     if (row < 0) {
@@ -0,0 +1,127 @@
+#include "kstore/qt/meta_list_pager.hpp"
+
+namespace kstore
+{
+QMetaListPager::QMetaListPager(QObject* parent)
+    : QObject(parent),
+      m_page_size(50),
+      m_prefetch(20),
+      m_next_id(0),
+      m_last_visible(-1),
+      m_has_more(true) {}
+QMetaListPager::~QMetaListPager() {}
+
+auto QMetaListPager::model() const -> QMetaListModel* { return m_model; }
+void QMetaListPager::setModel(QMetaListModel* v) {
+    if (m_model == v) return;
+    disconnect(m_fetch_connection);
+    disconnect(m_reset_connection);
+    m_model = v;
+    if (v) {
+        m_fetch_connection =
+            connect(v, &QMetaListModel::reqFetchMore, this, &QMetaListPager::onFetchMore);
+        m_reset_connection =
+            connect(v, &QAbstractItemModel::modelReset, this, &QMetaListPager::cancel);
+    }
+    reset();
+    modelChanged();
+}
+
+auto QMetaListPager::pageSize() const -> qint32 { return m_page_size; }
+void QMetaListPager::setPageSize(qint32 v) {
+    if (v < 1 || v == m_page_size) return;
+    m_page_size = v;
+    pageSizeChanged();
+}
+
+auto QMetaListPager::prefetchDistance() const -> qint32 { return m_prefetch; }
+void QMetaListPager::setPrefetchDistance(qint32 v) {
+    if (v < 0 || v == m_prefetch) return;
+    m_prefetch = v;
+    prefetchDistanceChanged();
+    maybeRequest();
+}
+
+auto QMetaListPager::loading() const -> bool { return m_inflight.has_value(); }
+auto QMetaListPager::stats() const -> const Stats& { return m_stats; }
+
+void QMetaListPager::setVisibleRange(qint32, qint32 last) {
+    m_last_visible = last;
+    maybeRequest();
+    // the view caught up with the rows loaded so far
+    if (m_model && last >= m_model->rowCount() - 1) wait();
+}
+
+void QMetaListPager::cancel() {
+    if (! m_inflight) return;
+    auto id = m_inflight->id;
+    m_stats.canceled++;
+    clearInflight();
+    pageCanceled(id);
+}
+
+void QMetaListPager::reset() {
+    cancel();
+    m_has_more     = true;
+    m_last_visible = -1;
+    if (m_model) m_model->setHasMore(true);
+}
+
+bool QMetaListPager::pageLoaded(qint32 id, const QVariantList& items, bool hasMore) {
+    if (! acceptPage(id)) return false;
+    m_model->insertItems(m_model->rowCount(), items);
+    pageDone(hasMore);
+    return true;
+}
+
+auto QMetaListPager::acceptPage(qint32 id) -> bool {
+    if (! m_model || ! m_inflight || m_inflight->id != id) {
+        m_stats.stale++;
+        return false;
+    }
+    auto latency = m_inflight->timer.elapsed();
+    m_stats.last_latency_ms = latency;
+    m_stats.total_latency_ms += latency;
+    if (! m_inflight->waited) m_stats.hits++;
+    clearInflight();
+    return true;
+}
+
+void QMetaListPager::pageDone(bool hasMore) {
+    m_has_more = hasMore;
+    if (m_model) m_model->setHasMore(hasMore);
+    maybeRequest();
+}
+
+void QMetaListPager::onFetchMore() {
+    // the view hit the last row, hasMore stays false until the page lands
+    if (! m_inflight && m_has_more) request();
+    wait();
+}
+
+void QMetaListPager::wait() {
+    if (! m_inflight || m_inflight->waited) return;
+    m_inflight->waited = true;
+    m_stats.misses++;
+}
+
+void QMetaListPager::maybeRequest() {
+    if (! m_model || m_inflight || ! m_has_more || m_last_visible < 0) return;
+    if (m_model->rowCount() - 1 - m_last_visible <= m_prefetch) request();
+}
+
+void QMetaListPager::request() {
+    auto id = ++m_next_id;
+    m_inflight.emplace(Page { id, m_model->rowCount(), false, {} });
+    m_inflight->timer.start();
+    m_stats.requests++;
+    loadingChanged();
+    reqPage(id, m_inflight->offset, m_page_size);
+}
+
+void QMetaListPager::clearInflight() {
+    m_inflight.reset();
+    loadingChanged();
+}
+
+} // namespace kstore
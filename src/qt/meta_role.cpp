@@ -18,6 +18,26 @@ void update_role_names(QHash<int, QByteArray>& role_names, const QMetaObject& me
 } // namespace detail
 
 QMetaRoleNames::QMetaRoleNames(): m_meta(QEmpty::staticMetaObject), m_opts(0) {}
+QMetaRoleNames::~QMetaRoleNames() {}
+void QMetaRoleNames::rowsWritten(usize, usize) const {}
+
+auto QMetaRoleNames::RoleAccessor::read(const void* gadget) const -> QVariant {
+    QVariant out;
+    int      status = -1;
+    void*    argv[] = { nullptr, nullptr, &status };
+    // as QMetaProperty::read, a QVariant property is written to the variant itself
+    if (type == QMetaType::fromType<QVariant>()) {
+        argv[0] = &out;
+    } else {
+        out     = QVariant(type);
+        argv[0] = out.data();
+    }
+    call(reinterpret_cast<QObject*>(const_cast<void*>(gadget)),
+         QMetaObject::ReadProperty,
+         index,
+         argv);
+    return out;
+}
 
 auto QMetaRoleNames::options() const -> int { return m_opts; }
 auto QMetaRoleNames::meta() const -> const QMetaObject& { return m_meta; }
@@ -29,6 +49,16 @@ auto QMetaRoleNames::roleOf(QByteArrayView name) const -> int {
     }
     return -1;
 }
+auto QMetaRoleNames::rolesOfMask(change_mask mask) const -> QList<int> {
+    QList<int> out;
+    if (mask == change_mask_all) return out;
+    for (auto it = m_role_infos.constBegin(); it != m_role_infos.constEnd(); ++it) {
+        if (it->is_method || (mask & change_mask_bit(it->index))) {
+            out.append(it.key());
+        }
+    }
+    return out;
+}
 void QMetaRoleNames::updateRoleNames(const QMetaObject& meta, QAbstractItemModel* model, int opts) {
     if (model) model->layoutAboutToBeChanged();
 
@@ -38,6 +68,7 @@ void QMetaRoleNames::updateRoleNames(const QMetaObject& meta, QAbstractItemModel
         m_role_names.clear();
         m_role_infos.clear();
         m_name_roles.clear();
+        m_role_accessors.clear();
 
         auto roleIndex = Qt::UserRole + 1;
         for (auto i = 0; i < meta.propertyCount(); i++) {
@@ -47,6 +78,13 @@ void QMetaRoleNames::updateRoleNames(const QMetaObject& meta, QAbstractItemModel
             m_name_roles.insert(name, roleIndex);
             m_role_infos.insert(roleIndex,
                                 RoleInfo { .name = name, .index = i, .is_method = false });
+            // unreadable or unregistered types are left to QMetaProperty
+            const bool direct = prop.isReadable() && prop.metaType().isValid();
+            m_role_accessors.append(
+                RoleAccessor { .call  = direct ? prop.enclosingMetaObject()->d.static_metacall
+                                               : nullptr,
+                               .index = prop.relativePropertyIndex(),
+                               .type  = prop.metaType() });
             ++roleIndex;
         }
 
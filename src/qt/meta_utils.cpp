@@ -1,4 +1,5 @@
 #include "kstore/qt/meta_utils.hpp"
+#include "kstore/item_diff.hpp"
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 #include <QtCore/QMetaObject>
@@ -6,44 +7,239 @@
 #include <QtCore/QSequentialIterable>
 #include <QtCore/QAssociativeIterable>
 
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
 namespace
 {
-auto qgadget_to_json(const QVariant& variant) -> QJsonObject {
-    auto obj  = QJsonObject();
-    auto meta = variant.metaType().metaObject();
-    for (int i = 0; i < meta->propertyCount(); ++i) {
-        auto prop = meta->property(i);
-        if (prop.metaType().flags() & QMetaType::IsPointer) {
-            // ignore
-        } else if (prop.isReadable() && prop.isStored()) {
-            auto value = prop.readOnGadget(variant.constData());
-            obj.insert(prop.name(), kstore::qvariant_to_josn(value));
+// builtin types written without a QVariant
+enum class ScalarKind
+{
+    None = 0,
+    Bool,
+    Int,
+    UInt,
+    LongLong,
+    ULongLong,
+    Double,
+    Float,
+    String
+};
+
+auto scalar_kind(const QMetaType& type) -> ScalarKind {
+    switch (type.id()) {
+    case QMetaType::Bool: return ScalarKind::Bool;
+    case QMetaType::Int: return ScalarKind::Int;
+    case QMetaType::UInt: return ScalarKind::UInt;
+    case QMetaType::LongLong: return ScalarKind::LongLong;
+    case QMetaType::ULongLong: return ScalarKind::ULongLong;
+    case QMetaType::Double: return ScalarKind::Double;
+    case QMetaType::Float: return ScalarKind::Float;
+    case QMetaType::QString: return ScalarKind::String;
+    default: return ScalarKind::None;
+    }
+}
+
+auto scalar_to_json(ScalarKind kind, const void* p) -> QJsonValue {
+    switch (kind) {
+    case ScalarKind::Bool: return *static_cast<const bool*>(p);
+    case ScalarKind::Int: return *static_cast<const int*>(p);
+    case ScalarKind::UInt: return qint64(*static_cast<const uint*>(p));
+    case ScalarKind::LongLong: return qint64(*static_cast<const qlonglong*>(p));
+    case ScalarKind::ULongLong: {
+        auto v = *static_cast<const qulonglong*>(p);
+        if (v <= qulonglong(std::numeric_limits<qint64>::max())) return qint64(v);
+        return double(v);
+    }
+    case ScalarKind::Double: return *static_cast<const double*>(p);
+    case ScalarKind::Float: return double(*static_cast<const float*>(p));
+    case ScalarKind::String: return *static_cast<const QString*>(p);
+    case ScalarKind::None: break;
+    }
+    return {};
+}
+
+// only values of the matching json type, the rest goes through QVariant conversion
+auto scalar_from_json(ScalarKind kind, const QJsonValue& v, void* p) -> bool {
+    auto integer = [&v]<typename I>(qint64 lo, qint64 hi, I* out) {
+        if (! v.isDouble()) return false;
+        auto i = v.toInteger();
+        if (double(i) != v.toDouble() || i < lo || i > hi) return false;
+        *out = static_cast<I>(i);
+        return true;
+    };
+    switch (kind) {
+    case ScalarKind::Bool:
+        if (! v.isBool()) return false;
+        *static_cast<bool*>(p) = v.toBool();
+        return true;
+    case ScalarKind::Int:
+        return integer(
+            std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), static_cast<int*>(p));
+    case ScalarKind::UInt:
+        return integer(0, std::numeric_limits<uint>::max(), static_cast<uint*>(p));
+    case ScalarKind::LongLong:
+        return integer(std::numeric_limits<qint64>::min(),
+                       std::numeric_limits<qint64>::max(),
+                       static_cast<qlonglong*>(p));
+    case ScalarKind::ULongLong:
+        return integer(0, std::numeric_limits<qint64>::max(), static_cast<qulonglong*>(p));
+    case ScalarKind::Double:
+        if (! v.isDouble()) return false;
+        *static_cast<double*>(p) = v.toDouble();
+        return true;
+    case ScalarKind::Float:
+        if (! v.isDouble()) return false;
+        *static_cast<float*>(p) = float(v.toDouble());
+        return true;
+    case ScalarKind::String:
+        if (! v.isString()) return false;
+        *static_cast<QString*>(p) = v.toString();
+        return true;
+    case ScalarKind::None: break;
+    }
+    return false;
+}
+
+// storage for any ScalarKind, a null QString does not allocate
+struct ScalarValue {
+    auto data(ScalarKind kind) -> void* {
+        return kind == ScalarKind::String ? (void*)&str : (void*)&num;
+    }
+
+    qulonglong num { 0 };
+    QString    str;
+};
+
+///
+/// @brief Properties of a gadget resolved once per QMetaObject
+/// @details
+/// Scalar properties are read and written through the moc generated static_metacall
+/// directly into typed storage, skipping the QVariant boxing of readOnGadget/writeOnGadget.
+struct GadgetPlan {
+    struct Field {
+        QMetaProperty                             prop;
+        QString                                   name;
+        ScalarKind                                kind;
+        bool                                      to_json;
+        bool                                      from_json;
+        QMetaObject::Data::StaticMetacallFunction call;
+        int                                       index;
+
+        void read(const void* gadget, void* out) const {
+            int   status = -1;
+            void* argv[] = { out, nullptr, &status };
+            call(reinterpret_cast<QObject*>(const_cast<void*>(gadget)),
+                 QMetaObject::ReadProperty,
+                 index,
+                 argv);
+        }
+        void write(void* gadget, void* in) const {
+            int   status = -1;
+            int   flags  = 0;
+            void* argv[] = { in, nullptr, &status, &flags };
+            call(reinterpret_cast<QObject*>(gadget), QMetaObject::WriteProperty, index, argv);
+        }
+    };
+
+    explicit GadgetPlan(const QMetaType& type) {
+        auto meta = type.metaObject();
+        for (int i = 0; i < meta->propertyCount(); ++i) {
+            auto prop = meta->property(i);
+            if (prop.metaType().flags() & QMetaType::IsPointer) continue;
+            Field f { .prop      = prop,
+                      .name      = QString::fromUtf8(prop.name()),
+                      .kind      = scalar_kind(prop.metaType()),
+                      .to_json   = prop.isReadable() && prop.isStored(),
+                      .from_json = prop.isWritable() && prop.isStored(),
+                      .call      = prop.enclosingMetaObject()->d.static_metacall,
+                      .index     = prop.relativePropertyIndex() };
+            if (! f.call) f.kind = ScalarKind::None;
+            if (f.to_json || f.from_json) fields.append(std::move(f));
+        }
+
+        // converters take precedence over the property walk, as in the generic paths
+        auto json_value = QMetaType::fromType<QJsonValue>();
+        auto json_obj   = QMetaType::fromType<QJsonObject>();
+        auto json_arr   = QMetaType::fromType<QJsonArray>();
+        auto assoc      = QMetaType::fromType<QAssociativeIterable>();
+        plain_to_json   = ! QMetaType::canConvert(type, assoc) &&
+                        ! QMetaType::canConvert(type, json_value) &&
+                        ! QMetaType::canConvert(type, json_obj) &&
+                        ! QMetaType::canConvert(type, json_arr);
+        plain_from_json = ! QMetaType::hasRegisteredConverterFunction(json_value, type) &&
+                          ! QMetaType::hasRegisteredConverterFunction(json_obj, type);
+    }
+
+    QList<Field> fields;
+    bool         plain_to_json;
+    bool         plain_from_json;
+};
+
+///
+/// @brief Process-wide plan of a gadget type, built on first use
+auto gadget_plan(const QMetaType& type) -> const GadgetPlan& {
+    static std::shared_mutex mutex;
+    static std::unordered_map<const QMetaObject*, std::unique_ptr<GadgetPlan>> plans;
+
+    auto meta = type.metaObject();
+    {
+        std::shared_lock lock(mutex);
+        if (auto it = plans.find(meta); it != plans.end()) return *it->second;
+    }
+    std::unique_lock lock(mutex);
+    auto&            plan = plans[meta];
+    if (! plan) plan = std::make_unique<GadgetPlan>(type);
+    return *plan;
+}
+
+auto qgadget_to_json(const void* gadget, const GadgetPlan& plan) -> QJsonObject {
+    auto obj = QJsonObject();
+    for (auto& f : plan.fields) {
+        if (! f.to_json) continue;
+        if (f.kind != ScalarKind::None) {
+            ScalarValue value;
+            f.read(gadget, value.data(f.kind));
+            obj.insert(f.name, scalar_to_json(f.kind, value.data(f.kind)));
+        } else {
+            obj.insert(f.name, kstore::qvariant_to_josn(f.prop.readOnGadget(gadget)));
         }
     }
     return obj;
 }
 
-auto qgadget_from_json(const QMetaType& type, const QJsonObject& obj) -> QVariant {
+auto qgadget_from_json(const QMetaType& type, const QJsonObject& obj, const GadgetPlan& plan)
+    -> QVariant {
     QVariant gadget(type, nullptr);
-    auto     meta = type.metaObject();
-    for (int i = 0; i < meta->propertyCount(); ++i) {
-        auto prop = meta->property(i);
-        if (prop.metaType().flags() & QMetaType::IsPointer) {
-            // ignore
-        } else if (prop.isWritable() && prop.isStored()) {
-            auto name = QString::fromUtf8(prop.name());
-            auto v    = obj.value(name);
-            if (! v.isUndefined()) {
-                QVariant propVar = kstore::qvariant_from_josn(prop.metaType(), v);
-                prop.writeOnGadget(gadget.data(), propVar);
+    for (auto& f : plan.fields) {
+        if (! f.from_json) continue;
+        auto v = obj.value(f.name);
+        if (v.isUndefined()) continue;
+        if (f.kind != ScalarKind::None) {
+            ScalarValue value;
+            if (scalar_from_json(f.kind, v, value.data(f.kind))) {
+                f.write(gadget.data(), value.data(f.kind));
+                continue;
             }
         }
+        f.prop.writeOnGadget(gadget.data(), kstore::qvariant_from_josn(f.prop.metaType(), v));
     }
     return gadget;
-} // namespace
+}
 } // namespace
 
 auto kstore::qvariant_to_josn(const QVariant& variant) -> QJsonValue {
+    if (auto kind = scalar_kind(variant.metaType()); kind != ScalarKind::None) {
+        return scalar_to_json(kind, variant.constData());
+    }
+    if (variant.metaType().flags() & QMetaType::IsGadget) {
+        if (auto& plan = gadget_plan(variant.metaType()); plan.plain_to_json) {
+            return qgadget_to_json(variant.constData(), plan);
+        }
+    }
+
     if (auto p = get_if<QVariantMap>(&variant)) {
         auto obj = QJsonObject();
         for (auto it = p->constBegin(); it != p->constEnd(); ++it) {
@@ -87,7 +283,7 @@ auto kstore::qvariant_to_josn(const QVariant& variant) -> QJsonValue {
         }
         //  try gadget
         else if (type.flags() & QMetaType::IsGadget) {
-            return qgadget_to_json(variant);
+            return qgadget_to_json(variant.constData(), gadget_plan(type));
         }
         // try sequential iterable
         else if (variant.canConvert<QSequentialIterable>()) {
@@ -106,6 +302,15 @@ auto kstore::qvariant_to_josn(const QVariant& variant) -> QJsonValue {
 }
 
 auto kstore::qvariant_from_josn(const QMetaType& type, const QJsonValue& value) -> QVariant {
+    if (auto kind = scalar_kind(type); kind != ScalarKind::None) {
+        QVariant out(type, nullptr);
+        if (scalar_from_json(kind, value, out.data())) return out;
+    } else if (value.isObject() && (type.flags() & QMetaType::IsGadget)) {
+        if (auto& plan = gadget_plan(type); plan.plain_from_json) {
+            return qgadget_from_json(type, value.toObject(), plan);
+        }
+    }
+
     if (QMetaType::hasRegisteredConverterFunction(QMetaType::fromType<QJsonValue>(), type)) {
         QVariant out(type, nullptr);
         QMetaType::convert(QMetaType::fromType<QJsonValue>(), &value, type, out.data());
@@ -137,7 +342,7 @@ auto kstore::qvariant_from_josn(const QMetaType& type, const QJsonValue& value)
         }
         if (type.flags() & QMetaType::IsGadget) {
             auto obj = value.toObject();
-            return qgadget_from_json(type, obj);
+            return qgadget_from_json(type, obj, gadget_plan(type));
         }
     } else if (value.isArray()) {
         if (type.id() == QMetaType::QVariantList) {
@@ -173,3 +378,16 @@ auto kstore::qvariant_from_josn(const QMetaType& type, const QJsonValue& value)
 
     return QVariant {};
 }
+
+auto kstore::qgadget_diff(const QMetaObject& meta, const void* a, const void* b) -> change_mask {
+    change_mask out = 0;
+    for (int i = 0; i < meta.propertyCount(); ++i) {
+        auto bit = change_mask_bit(i);
+        if (out & bit) continue;
+        auto prop = meta.property(i);
+        if (! prop.isReadable()) continue;
+        // QVariant compares with QMetaType::equals, types without operator== always differ
+        if (prop.readOnGadget(a) != prop.readOnGadget(b)) out |= bit;
+    }
+    return out;
+}
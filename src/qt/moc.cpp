@@ -1,4 +1,5 @@
 
 #include "kstore/qt/moc_meta_role.cpp"
 #include "kstore/qt/moc_meta_list_model.cpp"
+#include "kstore/qt/moc_meta_list_pager.cpp"
 #include "kstore/qt/moc_qtable_proxy_model.cpp"
\ No newline at end of file
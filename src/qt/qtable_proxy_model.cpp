@@ -9,20 +9,48 @@ QTableProxyModel::QTableProxyModel(QObject* parent): QAbstractProxyModel(parent)
 
 void QTableProxyModel::syncColumns() {
     if (! sourceModel()) return;
-    beginResetModel();
-    m_headers.clear();
-    auto        roles = sourceModel()->roleNames();
-    const auto& r     = roles.asKeyValueRange();
+    std::vector<HeaderData> headers;
+    auto                    roles = sourceModel()->roleNames();
+    const auto&             r     = roles.asKeyValueRange();
     for (auto i = 0; i < m_column_names.size(); i++) {
         auto& col = m_column_names[i];
         auto  it  = std::find_if(r.begin(), r.end(), [&col](auto v) {
             return v.second == col;
         });
         if (it != r.end()) {
-            m_headers.push_back({ .role = it->first, .propname = it->second });
+            headers.push_back({ .role = it->first, .propname = it->second });
+        }
+    }
+
+    // drop the columns that are gone, a repeated column is kept as many times as it is wanted
+    auto wanted = headers;
+    for (int i = 0; i < (int)m_headers.size();) {
+        if (auto it = std::ranges::find(wanted, m_headers[i]); it != wanted.end()) {
+            wanted.erase(it);
+            ++i;
+            continue;
+        }
+        beginRemoveColumns({}, i, i);
+        m_headers.erase(m_headers.begin() + i);
+        endRemoveColumns();
+    }
+    // then move the kept ones into place and insert the new ones
+    for (int i = 0; i < (int)headers.size(); i++) {
+        if (i < (int)m_headers.size() && m_headers[i] == headers[i]) continue;
+        auto it = std::find(m_headers.begin() + std::min<std::size_t>(i, m_headers.size()),
+                            m_headers.end(),
+                            headers[i]);
+        if (it != m_headers.end()) {
+            const int from = it - m_headers.begin();
+            beginMoveColumns({}, from, from, {}, i);
+            std::rotate(m_headers.begin() + i, it, it + 1);
+            endMoveColumns();
+        } else {
+            beginInsertColumns({}, i, i);
+            m_headers.insert(m_headers.begin() + i, headers[i]);
+            endInsertColumns();
         }
     }
-    endResetModel();
 }
 
 auto QTableProxyModel::columnNames() const -> const QStringList { return m_column_names; }
@@ -127,6 +155,19 @@ auto QTableProxyModel::data(const QModelIndex& proxyIndex, int role) const -> QV
     }
     return QAbstractProxyModel::data(proxyIndex, role);
 }
+void QTableProxyModel::multiData(const QModelIndex& proxyIndex,
+                                 QModelRoleDataSpan roleDataSpan) const {
+    if (! sourceModel()) return;
+    auto column = proxyIndex.isValid() ? proxyIndex.column() : -1;
+    if (column < 0 || (std::size_t)column >= m_headers.size()) {
+        sourceModel()->multiData(mapToSource(proxyIndex), roleDataSpan);
+        return;
+    }
+    // every role of a cell is its column's role, fetch it once
+    QModelRoleData cell(m_headers[column].role);
+    sourceModel()->multiData(mapToSource(proxyIndex), cell);
+    for (auto& d : roleDataSpan) d.setData(cell.data());
+}
 auto QTableProxyModel::headerData(int section, Qt::Orientation orientation, int role) const
     -> QVariant {
     if (section > 0 && (std::size_t)section < m_headers.size()) {
@@ -151,26 +192,88 @@ auto QTableProxyModel::index(int row, int column, const QModelIndex&) const -> Q
     return QAbstractProxyModel::createIndex(row, column, nullptr);
 }
 
-void QTableProxyModel::sourceDataChanged() {}
-void QTableProxyModel::sourceHeaderDataChanged() {}
-void QTableProxyModel::sourceRowsAboutToBeInserted() {}
-void QTableProxyModel::sourceRowsInserted() {}
+void QTableProxyModel::sourceDataChanged(const QModelIndex& topLeft,
+                                         const QModelIndex& bottomRight, const QList<int>& roles) {
+    if (topLeft.parent().isValid() || m_headers.empty()) return;
+    const int top     = topLeft.row();
+    const int bottom  = bottomRight.row();
+    const int columns = m_headers.size();
+    if (roles.isEmpty()) {
+        dataChanged(index(top, 0, {}), index(bottom, columns - 1, {}));
+        return;
+    }
+    // one signal per run of adjacent columns showing a changed role
+    int run = -1;
+    for (int c = 0; c <= columns; c++) {
+        const bool hit = c < columns && roles.contains(m_headers[c].role);
+        if (hit && run < 0) {
+            run = c;
+        } else if (! hit && run >= 0) {
+            dataChanged(index(top, run, {}), index(bottom, c - 1, {}));
+            run = -1;
+        }
+    }
+}
+void QTableProxyModel::sourceHeaderDataChanged(Qt::Orientation orientation, int first, int last) {
+    // horizontal headers are the column names
+    if (orientation == Qt::Vertical) headerDataChanged(orientation, first, last);
+}
+void QTableProxyModel::sourceRowsAboutToBeInserted(const QModelIndex& parent, int first,
+                                                   int last) {
+    if (! parent.isValid()) beginInsertRows({}, first, last);
+}
+void QTableProxyModel::sourceRowsInserted(const QModelIndex& parent) {
+    if (! parent.isValid()) endInsertRows();
+}
+// proxy columns are roles of the source, the source's own columns are not shown
 void QTableProxyModel::sourceColumnsAboutToBeInserted() {}
 void QTableProxyModel::sourceColumnsInserted() {}
-void QTableProxyModel::sourceRowsAboutToBeRemoved() {}
-void QTableProxyModel::sourceRowsRemoved() {}
+void QTableProxyModel::sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last) {
+    if (! parent.isValid()) beginRemoveRows({}, first, last);
+}
+void QTableProxyModel::sourceRowsRemoved(const QModelIndex& parent) {
+    if (! parent.isValid()) endRemoveRows();
+}
 void QTableProxyModel::sourceColumnsAboutToBeRemoved() {}
 void QTableProxyModel::sourceColumnsRemoved() {}
-void QTableProxyModel::sourceRowsAboutToBeMoved() {}
-void QTableProxyModel::sourceRowsMoved() {}
+void QTableProxyModel::sourceRowsAboutToBeMoved(const QModelIndex& sourceParent, int sourceStart,
+                                                int sourceEnd, const QModelIndex& destinationParent,
+                                                int destinationRow) {
+    if (sourceParent.isValid() || destinationParent.isValid()) return;
+    beginMoveRows({}, sourceStart, sourceEnd, {}, destinationRow);
+}
+void QTableProxyModel::sourceRowsMoved(const QModelIndex& sourceParent) {
+    if (! sourceParent.isValid()) endMoveRows();
+}
 void QTableProxyModel::sourceColumnsAboutToBeMoved() {}
 void QTableProxyModel::sourceColumnsMoved() {}
-void QTableProxyModel::sourceLayoutAboutToBeChanged(const QList<QPersistentModelIndex>&  sourceParents,
-                                           QAbstractItemModel::LayoutChangeHint hint) {}
-void QTableProxyModel::sourceLayoutChanged(const QList<QPersistentModelIndex>&  sourceParents,
+void QTableProxyModel::sourceLayoutAboutToBeChanged(const QList<QPersistentModelIndex>&,
+                                                    QAbstractItemModel::LayoutChangeHint hint) {
+    layoutAboutToBeChanged({}, hint);
+    m_layout_proxy = persistentIndexList();
+    m_layout_source.clear();
+    m_layout_source.reserve(m_layout_proxy.size());
+    for (auto& idx : std::as_const(m_layout_proxy)) {
+        m_layout_source.append(QPersistentModelIndex(mapToSource(idx)));
+    }
+}
+void QTableProxyModel::sourceLayoutChanged(const QList<QPersistentModelIndex>&,
                                            QAbstractItemModel::LayoutChangeHint hint) {
+    QModelIndexList moved;
+    moved.reserve(m_layout_proxy.size());
+    for (qsizetype i = 0; i < m_layout_proxy.size(); i++) {
+        auto& src = m_layout_source[i];
+        moved.append(src.isValid() ? index(src.row(), m_layout_proxy[i].column(), {})
+                                   : QModelIndex {});
+    }
+    changePersistentIndexList(m_layout_proxy, moved);
+    m_layout_proxy.clear();
+    m_layout_source.clear();
+    layoutChanged({}, hint);
 
-                                           }
+    // role names are updated under a layout change
+    syncColumns();
+}
 void QTableProxyModel::sourceAboutToBeReset() { beginResetModel(); }
 void QTableProxyModel::sourceReset() { endResetModel(); }
 
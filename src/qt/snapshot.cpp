@@ -0,0 +1,61 @@
+#include "kstore/qt/snapshot.hpp"
+
+namespace
+{
+// FNV-1a, qHash is seeded per process
+constexpr quint64 fnv_offset = 14695981039346656037ull;
+constexpr quint64 fnv_prime  = 1099511628211ull;
+
+void fnv_add(quint64& hash, QByteArrayView bytes) {
+    for (auto c : bytes) {
+        hash ^= (quint8)c;
+        hash *= fnv_prime;
+    }
+    // separator, so "ab" + "c" differs from "a" + "bc"
+    hash ^= 0xff;
+    hash *= fnv_prime;
+}
+} // namespace
+
+auto kstore::snapshot_properties(const QMetaObject& meta) -> QList<QMetaProperty> {
+    QList<QMetaProperty> out;
+    for (int i = 0; i < meta.propertyCount(); ++i) {
+        auto prop = meta.property(i);
+        if (prop.metaType().flags() & QMetaType::IsPointer) continue;
+        // QMetaType::save() and load() fail for these, they would end the item early
+        if (! prop.metaType().hasRegisteredDataStreamOperators()) continue;
+        if (prop.isReadable() && prop.isWritable() && prop.isStored()) out.append(prop);
+    }
+    return out;
+}
+
+auto kstore::snapshot_schema_hash(const QMetaObject& meta, QMetaType key) -> quint64 {
+    quint64 hash = fnv_offset;
+    fnv_add(hash, meta.className());
+    fnv_add(hash, key.name());
+    for (auto& prop : snapshot_properties(meta)) {
+        fnv_add(hash, prop.name());
+        fnv_add(hash, prop.metaType().name());
+    }
+    return hash;
+}
+
+void kstore::snapshot_write_gadget(QDataStream& s, const QList<QMetaProperty>& props,
+                                   const void* gadget) {
+    for (auto& prop : props) {
+        auto value = prop.readOnGadget(gadget);
+        prop.metaType().save(s, value.constData());
+    }
+}
+
+auto kstore::snapshot_read_gadget(QDataStream& s, const QList<QMetaProperty>& props,
+                                  void* gadget) -> bool {
+    for (auto& prop : props) {
+        QVariant value(prop.metaType());
+        if (! prop.metaType().load(s, value.data()) || s.status() != QDataStream::Ok) {
+            return false;
+        }
+        prop.writeOnGadget(gadget, std::move(value));
+    }
+    return true;
+}
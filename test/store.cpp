@@ -1,7 +1,18 @@
 #include <format>
+#include <thread>
 #include <gtest/gtest.h>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTemporaryDir>
 
 #include "kstore/qt/gadget_model.hpp"
+#include "kstore/qt/meta_list_pager.hpp"
+#include "kstore/qt/qtable_proxy_model.hpp"
+#include "kstore/qt/snapshot.hpp"
+#include "kstore/qt/meta_utils.hpp"
+#include "kstore/qt/json_stream.hpp"
+#include "kstore/concurrent_store.hpp"
+#include "kstore/pmr.hpp"
+#include "kstore/scratch_arena.hpp"
 
 struct Model {
     Q_GADGET
@@ -26,6 +37,182 @@ public:
     ListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
 };
 
+struct TreeListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<Model, TreeListModel, kstore::ListStoreType::Tree> {
+    Q_OBJECT
+public:
+    TreeListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+struct MapListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<Model, MapListModel, kstore::ListStoreType::VectorWithMap> {
+    Q_OBJECT
+public:
+    MapListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+// all content in properties, so it opts into the per-property diff
+struct Person {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(int age MEMBER age)
+public:
+    int uid;
+    int age { 18 };
+};
+
+template<>
+struct kstore::ItemTrait<Person> {
+    using key_type   = int;
+    using store_type = kstore::ShareStore<Person>;
+    static auto key(kstore::param_type<Person> m) { return m.uid; }
+    static auto diff(const Person& a, const Person& b) { return kstore::gadget_diff(a, b); }
+};
+
+struct PersonListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<Person, PersonListModel, kstore::ListStoreType::Share> {
+    Q_OBJECT
+public:
+    PersonListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+struct PersonMapListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<Person, PersonMapListModel, kstore::ListStoreType::VectorWithMap> {
+    Q_OBJECT
+public:
+    PersonMapListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+struct VirtualListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<Model, VirtualListModel, kstore::ListStoreType::Virtual> {
+    Q_OBJECT
+public:
+    VirtualListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+struct SharedItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(QString name MEMBER name)
+public:
+    int     uid;
+    QString name;
+};
+
+template<>
+struct kstore::ItemTrait<SharedItem> {
+    using key_type   = int;
+    using store_type = kstore::ConcurrentShareStore<SharedItem>;
+    static auto key(kstore::param_type<SharedItem> m) { return m.uid; }
+};
+
+struct SharedListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<SharedItem, SharedListModel, kstore::ListStoreType::Share> {
+    Q_OBJECT
+public:
+    SharedListModel(QObject* p = nullptr): kstore::QGadgetListModel(this, p) {}
+};
+
+struct PmrItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(int age MEMBER age)
+public:
+    int uid;
+    int age { 18 };
+};
+
+template<>
+struct kstore::ItemTrait<PmrItem> {
+    using key_type   = int;
+    using store_type = kstore::pmr::ShareStore<PmrItem>;
+    static auto key(kstore::param_type<PmrItem> m) { return m.uid; }
+};
+
+struct PmrListModel
+    : kstore::QGadgetListModel,
+      kstore::pmr::QMetaListModelCRTP<PmrItem, PmrListModel, kstore::ListStoreType::Share> {
+    Q_OBJECT
+public:
+    PmrListModel(std::pmr::memory_resource* res, QObject* p = nullptr)
+        : kstore::QGadgetListModel(this, p),
+          kstore::pmr::QMetaListModelCRTP<PmrItem, PmrListModel, kstore::ListStoreType::Share>(
+              res) {}
+};
+
+// inner has no data stream operators
+struct NestedItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+    Q_PROPERTY(Model inner MEMBER inner)
+    Q_PROPERTY(int age MEMBER age)
+public:
+    int   uid;
+    Model inner { 0 };
+    int   age { 18 };
+};
+
+template<>
+struct kstore::ItemTrait<NestedItem> {
+    using key_type   = int;
+    using store_type = kstore::ShareStore<NestedItem>;
+    static auto key(kstore::param_type<NestedItem> m) { return m.uid; }
+};
+
+struct MethodItem {
+    Q_GADGET
+
+    Q_PROPERTY(int uid MEMBER uid)
+public:
+    Q_INVOKABLE int doubled() const {
+        ++calls;
+        return uid * factor;
+    }
+
+    int               uid;
+    // not a property, item_diff does not see it
+    int               factor { 2 };
+    static inline int calls { 0 };
+};
+
+template<>
+struct kstore::ItemTrait<MethodItem> {
+    using key_type   = int;
+    using store_type = kstore::ShareStore<MethodItem>;
+    static auto key(kstore::param_type<MethodItem> m) { return m.uid; }
+    static auto diff(const MethodItem& a, const MethodItem& b) { return kstore::gadget_diff(a, b); }
+};
+
+struct MethodListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<MethodItem, MethodListModel, kstore::ListStoreType::Vector> {
+    Q_OBJECT
+public:
+    MethodListModel(QObject* p = nullptr)
+        : kstore::QGadgetListModel(
+              this, p, kstore::QMetaRoleNames::WithMethod | kstore::QMetaRoleNames::CacheMethod) {}
+};
+
+struct MethodShareListModel
+    : kstore::QGadgetListModel,
+      kstore::QMetaListModelCRTP<MethodItem, MethodShareListModel, kstore::ListStoreType::Share> {
+    Q_OBJECT
+public:
+    MethodShareListModel(QObject* p = nullptr)
+        : kstore::QGadgetListModel(
+              this, p, kstore::QMetaRoleNames::WithMethod | kstore::QMetaRoleNames::CacheMethod) {}
+};
+
 TEST(Store, Basic) {
     kstore::ShareStore<Model> store;
 
@@ -55,4 +242,958 @@ TEST(Store, Share) {
     EXPECT_EQ(m.at(1).age, 20);
 }
 
+TEST(Store, FlatMap) {
+    kstore::ShareStore<Model, std::allocator<Model>, void, std::int64_t, kstore::StoreMapType::Flat>
+        store;
+
+    for (int i = 1; i <= 1000; i++) {
+        store.store_insert(Model { i, i % 100 });
+    }
+    EXPECT_EQ(store.size(), 1000);
+    EXPECT_EQ(store.store_query(500)->age, 0);
+    EXPECT_EQ(store.store_query(1001), nullptr);
+
+    for (int i = 1; i <= 1000; i += 2) {
+        store.store_remove(i);
+    }
+    EXPECT_EQ(store.size(), 500);
+    EXPECT_EQ(store.store_query(499), nullptr);
+    EXPECT_EQ(store.store_query(498)->age, 98);
+}
+
+TEST(Store, FlatMapMoveAssign) {
+    using Alloc = std::pmr::polymorphic_allocator<std::pair<const int, std::pmr::string>>;
+    using Map =
+        kstore::FlatHashMap<int, std::pmr::string, std::hash<int>, std::equal_to<int>, Alloc>;
+    std::pmr::monotonic_buffer_resource a, b;
+    Map                                 x(&a), y(&b), z(&a);
+    for (int i = 0; i < 100; i++) x[i] = std::to_string(i);
+    y[5] = "old";
+
+    // another resource, the items are moved over one by one
+    y = std::move(x);
+    EXPECT_EQ(y.size(), 100);
+    EXPECT_EQ(y.find(42)->second, "42");
+    EXPECT_EQ(y.find(5)->second, "5");
+    EXPECT_EQ(y.get_allocator().resource(), &b);
+    EXPECT_TRUE(x.empty());
+
+    // the same resource, the storage is taken over
+    z = std::move(y);
+    EXPECT_EQ(z.size(), 100);
+    EXPECT_EQ(z.get_allocator().resource(), &a);
+    EXPECT_TRUE(y.empty());
+}
+
+TEST(Store, Concurrent) {
+    kstore::ConcurrentShareStore<Model> store;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++) {
+        producers.emplace_back([&store, t] {
+            for (int i = 1; i <= 1000; i++) {
+                auto [item, _] = store.store_insert(Model { t * 1000 + i, t });
+                item.increase();
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+
+    EXPECT_EQ(store.size(), 4000);
+    EXPECT_EQ(store.store_get(2500)->age, 2);
+    EXPECT_FALSE(store.store_get(5000));
+}
+
+TEST(Store, ConcurrentUpdate) {
+    int              argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    kstore::ConcurrentShareStore<SharedItem> store;
+    SharedListModel                          m;
+    m.set_store(&m, store);
+    std::vector<SharedItem> items;
+    for (int i = 0; i < 64; i++) items.push_back(SharedItem { i, QStringLiteral("init") });
+    m.insert(0, items);
+
+    // producers replace the items the model is reading
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++) {
+        producers.emplace_back([&store, t] {
+            for (int i = 0; i < 2000; i++) {
+                auto name = QString(20 + i % 30, QChar('a' + t));
+                store.store_insert_range(std::array { SharedItem { (i * 7 + t) % 64, name } });
+            }
+        });
+    }
+    const auto name = m.roleOf("name");
+    qsizetype  read = 0;
+    for (int i = 0; i < 20000; i++) {
+        read += m.data(m.index(i % 64), name).toString().size();
+        if (i % 100 == 0) QCoreApplication::processEvents();
+    }
+    for (auto& t : producers) t.join();
+    EXPECT_GT(read, 0);
+
+    // queued notifications bring every row up to the store
+    QCoreApplication::processEvents();
+    for (int i = 0; i < 64; i++) {
+        EXPECT_EQ(m.at(i).name, store.store_get(i)->name);
+    }
+
+    // an edit through one model is written to the store, the other list sees it too
+    SharedListModel other;
+    other.set_store(&other, store);
+    other.insert(0, std::array { *store.store_get(0) });
+    EXPECT_TRUE(m.setData(m.index(0), QStringLiteral("edited"), name));
+    EXPECT_EQ(m.at(0).name, QStringLiteral("edited"));
+    EXPECT_EQ(store.store_get(0)->name, QStringLiteral("edited"));
+    QCoreApplication::processEvents();
+    EXPECT_EQ(other.at(0).name, QStringLiteral("edited"));
+}
+
+TEST(Store, WeakItem) {
+    std::optional<kstore::ShareStore<Model>::weak_store_item_type> item;
+    {
+        kstore::ShareStore<Model> store;
+        store.store_insert(Model { 1, 10 });
+        item = store.store_weak_item(1);
+
+        ASSERT_TRUE(item);
+        EXPECT_EQ(item->item()->age, 10);
+    }
+    // the weak handle did not keep the store alive
+    EXPECT_EQ(item->item(), nullptr);
+}
+
+TEST(Store, InsertRange) {
+    kstore::ShareStore<Model> store;
+    store.store_insert(Model { 1 });
+
+    std::vector<int> changed;
+    store.store_reg_notify([&changed](std::span<const int> keys) {
+        changed.insert(changed.end(), keys.begin(), keys.end());
+    });
+
+    auto results = store.store_insert_range(std::array { Model { 1, 10 }, Model { 2, 20 } });
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0], kstore::UpsertResult::Updated);
+    EXPECT_EQ(results[1], kstore::UpsertResult::Inserted);
+    EXPECT_EQ(changed, std::vector { 1 });
+    EXPECT_EQ(store.store_query(2)->age, 20);
+}
+
+TEST(Store, ChangedRuns) {
+    kstore::ShareStore<Model> store;
+
+    ListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Model { 1 }, Model { 2 }, Model { 3 }, Model { 4 }, Model { 5 } });
+
+    std::vector<std::pair<int, int>> runs;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     [&runs](const QModelIndex& first, const QModelIndex& last) {
+                         runs.emplace_back(first.row(), last.row());
+                     });
+
+    store.store_insert_range(
+        std::array { Model { 4, 1 }, Model { 1, 1 }, Model { 2, 1 }, Model { 5, 1 } });
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>> { { 0, 1 }, { 3, 4 } }));
+
+    runs.clear();
+    m.set_changed_threshold(2);
+    store.store_insert_range(std::array { Model { 4, 2 }, Model { 1, 2 }, Model { 2, 2 } });
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>> { { 0, 4 } }));
+}
+
+TEST(Store, ChangeMask) {
+    kstore::ShareStore<Person> store;
+
+    PersonListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Person { 1 }, Person { 2 } });
+
+    std::vector<QList<int>> roles;
+    QObject::connect(&m,
+                     &QAbstractItemModel::dataChanged,
+                     [&roles](const QModelIndex&, const QModelIndex&, const QList<int>& r) {
+                         roles.push_back(r);
+                     });
+
+    auto results = store.store_insert_range(std::array { Person { 1 }, Person { 2, 20 } });
+    EXPECT_EQ(results[0], kstore::UpsertResult::Unchanged);
+    EXPECT_EQ(results[1], kstore::UpsertResult::Updated);
+    ASSERT_EQ(roles.size(), 1);
+    EXPECT_EQ(roles[0], QList<int> { m.roleOf("age") });
+}
+
+TEST(Store, RoutedNotify) {
+    kstore::ShareStore<Model> store;
+
+    ListModel a;
+    ListModel b;
+    a.set_store(&a, store);
+    b.set_store(&b, store);
+    a.insert(0, std::array { Model { 1 }, Model { 2 } });
+    b.insert(0, std::array { Model { 2 }, Model { 3 } });
+
+    int a_changed = 0, b_changed = 0;
+    QObject::connect(&a, &QAbstractItemModel::dataChanged, [&a_changed] {
+        ++a_changed;
+    });
+    QObject::connect(&b, &QAbstractItemModel::dataChanged, [&b_changed] {
+        ++b_changed;
+    });
+
+    std::vector<int> heard;
+    auto             handle = store.store_reg_routed_notify(
+        [&heard](std::span<const int> keys, std::span<const kstore::change_mask>) {
+            heard.insert(heard.end(), keys.begin(), keys.end());
+        });
+    store.store_subscribe(handle, std::array { 3 });
+
+    // only b holds 3
+    store.store_insert_range(std::array { Model { 3, 30 } });
+    EXPECT_EQ(a_changed, 0);
+    EXPECT_EQ(b_changed, 1);
+    EXPECT_EQ(heard, std::vector<int> { 3 });
+
+    store.store_insert_range(std::array { Model { 2, 20 } });
+    EXPECT_EQ(a_changed, 1);
+    EXPECT_EQ(b_changed, 2);
+    EXPECT_EQ(heard, std::vector<int> { 3 });
+
+    // an erased row no longer routes to its list
+    b.remove(0);
+    store.store_insert_range(std::array { Model { 2, 21 } });
+    EXPECT_EQ(a_changed, 2);
+    EXPECT_EQ(b_changed, 2);
+
+    store.store_unsubscribe(handle, std::array { 3 });
+    store.store_insert_range(std::array { Model { 3, 31 } });
+    EXPECT_EQ(b_changed, 3);
+    EXPECT_EQ(heard, std::vector<int> { 3 });
+    store.store_unreg_notify(handle);
+}
+
+TEST(Store, RoleData) {
+    kstore::ShareStore<Person> store;
+
+    PersonListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Person { 1 }, Person { 2, 20 } });
+
+    auto age = m.data(m.index(1), m.roleOf("age"));
+    EXPECT_EQ(age.metaType(), QMetaType::fromType<int>());
+    EXPECT_EQ(age.toInt(), 20);
+    EXPECT_EQ(m.data(m.index(0), m.roleOf("uid")).toInt(), 1);
+    EXPECT_FALSE(m.data(m.index(0), Qt::DisplayRole).isValid());
+    EXPECT_FALSE(m.data(m.index(0), Qt::UserRole + 100).isValid());
+
+    EXPECT_TRUE(m.setData(m.index(0), 30, m.roleOf("age")));
+    EXPECT_EQ(m.data(m.index(0), m.roleOf("age")).toInt(), 30);
+}
+
+TEST(Store, MultiData) {
+    kstore::ShareStore<Person> store;
+
+    PersonListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Person { 1 }, Person { 2, 20 } });
+
+    std::array roles { QModelRoleData(m.roleOf("uid")),
+                       QModelRoleData(m.roleOf("age")),
+                       QModelRoleData(Qt::DisplayRole) };
+    m.multiData(m.index(1), roles);
+    EXPECT_EQ(roles[0].data().toInt(), 2);
+    EXPECT_EQ(roles[1].data().toInt(), 20);
+    EXPECT_FALSE(roles[2].data().isValid());
+
+    m.multiData(m.index(5), roles);
+    EXPECT_FALSE(roles[0].data().isValid());
+
+    kstore::QTableProxyModel table;
+    table.setSourceModel(&m);
+    table.setColumnNames({ "age", "uid" });
+    QModelRoleData cell(Qt::DisplayRole);
+    table.multiData(table.index(1, 0, {}), cell);
+    EXPECT_EQ(cell.data().toInt(), 20);
+    table.multiData(table.index(1, 1, {}), cell);
+    EXPECT_EQ(cell.data().toInt(), 2);
+}
+
+TEST(Store, MethodCache) {
+    MethodListModel m;
+    m.insert(0, std::array { MethodItem { 1 }, MethodItem { 2 } });
+    const auto role = m.roleOf("doubled");
+    MethodItem::calls = 0;
+
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 4);
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 4);
+    EXPECT_EQ(MethodItem::calls, 1);
+
+    // the row's dataChanged drops its results only
+    EXPECT_EQ(m.data(m.index(0), role).toInt(), 2);
+    EXPECT_TRUE(m.setData(m.index(1), 5, m.roleOf("uid")));
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 10);
+    EXPECT_EQ(m.data(m.index(0), role).toInt(), 2);
+    EXPECT_EQ(MethodItem::calls, 3);
+
+    // rows shifted
+    m.insert(0, std::array { MethodItem { 7 } });
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 2);
+    EXPECT_EQ(MethodItem::calls, 4);
+
+    // a write item_diff sees no change in is not signalled, yet drops the row's results
+    int changed = 0;
+    QObject::connect(&m, &QAbstractItemModel::dataChanged, [&changed] {
+        ++changed;
+    });
+    m.sync(std::array { MethodItem { 7 }, MethodItem { 1, 3 }, MethodItem { 5 } });
+    EXPECT_EQ(changed, 0);
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 3);
+}
+
+TEST(Store, MethodCacheStore) {
+    kstore::ShareStore<MethodItem> store;
+    MethodShareListModel           m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { MethodItem { 1 }, MethodItem { 2 } });
+    const auto role = m.roleOf("doubled");
+    EXPECT_EQ(m.data(m.index(0), role).toInt(), 2);
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 4);
+
+    // the store reports the write with a mask of 0
+    int changed = 0;
+    QObject::connect(&m, &QAbstractItemModel::dataChanged, [&changed] {
+        ++changed;
+    });
+    store.store_insert_range(std::array { MethodItem { 2, 5 } });
+    EXPECT_EQ(changed, 0);
+    EXPECT_EQ(m.data(m.index(1), role).toInt(), 10);
+    EXPECT_EQ(m.data(m.index(0), role).toInt(), 2);
+}
+
+TEST(Store, TableProxy) {
+    kstore::ShareStore<Person> store;
+
+    PersonListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Person { 1 }, Person { 2 } });
+
+    kstore::QTableProxyModel table;
+    table.setSourceModel(&m);
+    table.setColumnNames({ "uid", "age" });
+    ASSERT_EQ(table.columnCount(), 2);
+
+    int                              resets = 0;
+    std::vector<std::pair<int, int>> changed;
+    std::vector<std::pair<int, int>> inserted;
+    QObject::connect(&table, &QAbstractItemModel::modelReset, [&resets] {
+        ++resets;
+    });
+    QObject::connect(&table,
+                     &QAbstractItemModel::dataChanged,
+                     [&changed](const QModelIndex& first, const QModelIndex& last) {
+                         changed.emplace_back(first.row(), last.column());
+                     });
+    QObject::connect(&table,
+                     &QAbstractItemModel::rowsInserted,
+                     [&inserted](const QModelIndex&, int first, int last) {
+                         inserted.emplace_back(first, last);
+                     });
+
+    m.insert(2, std::array { Person { 3 } });
+    EXPECT_EQ(inserted, (std::vector<std::pair<int, int>> { { 2, 2 } }));
+    EXPECT_EQ(table.rowCount(), 3);
+
+    // only the age column of row 1
+    store.store_insert_range(std::array { Person { 2, 30 } });
+    EXPECT_EQ(changed, (std::vector<std::pair<int, int>> { { 1, 1 } }));
+    EXPECT_EQ(table.data(table.index(1, 1, {})).toInt(), 30);
+
+    m.remove(0);
+    EXPECT_EQ(table.rowCount(), 2);
+    EXPECT_EQ(table.data(table.index(0, 0, {})).toInt(), 2);
+
+    int columns_inserted = 0, columns_removed = 0;
+    QObject::connect(&table, &QAbstractItemModel::columnsInserted, [&columns_inserted] {
+        ++columns_inserted;
+    });
+    QObject::connect(&table, &QAbstractItemModel::columnsRemoved, [&columns_removed] {
+        ++columns_removed;
+    });
+    table.setColumnNames({ "age" });
+    EXPECT_EQ(columns_removed, 1);
+    table.setColumnNames({ "age", "uid" });
+    EXPECT_EQ(columns_inserted, 1);
+    EXPECT_EQ(table.data(table.index(0, 1, {})).toInt(), 2);
+    EXPECT_EQ(resets, 0);
+}
+
+TEST(Store, Slot) {
+    kstore::ShareStore<Model> store;
+    auto [item, _] = store.store_insert(Model { 1, 10 });
+    auto slot      = item.slot();
+    EXPECT_EQ(store.store_at(slot)->age, 10);
+    EXPECT_EQ(item->age, 10);
+
+    // drop the store's own reference, then the item's
+    store.store_remove(1);
+    item = kstore::ShareStore<Model>::store_item_type { store };
+    EXPECT_EQ(store.store_at(slot), nullptr);
+
+    // the slot is reused with a new generation
+    auto [other, __] = store.store_insert(Model { 2, 20 });
+    EXPECT_EQ(other.slot().index, slot.index);
+    EXPECT_EQ(store.store_at(slot), nullptr);
+    EXPECT_EQ(store.store_at(other.slot())->age, 20);
+}
+
+TEST(Store, IterateByRef) {
+    kstore::ShareStore<Model> store;
+
+    ListModel m;
+    m.set_store(&m, store);
+    m.insert(0, std::array { Model { 1 }, Model { 2 } });
+
+    for (auto& el : m) {
+        el.age = 30;
+    }
+    EXPECT_EQ(store.store_query(1)->age, 30);
+    EXPECT_EQ(store.store_query(2)->age, 30);
+}
+
+TEST(Store, Retention) {
+    kstore::ShareStore<Model> store;
+    store.set_retention(2);
+    {
+        ListModel m;
+        m.set_store(&m, store);
+        m.insert(0, std::array { Model { 1 }, Model { 2 }, Model { 3 } });
+    }
+    // the oldest released entry is evicted
+    EXPECT_EQ(store.size(), 2);
+    EXPECT_EQ(store.stats().evictions, 1);
+    EXPECT_EQ(store.store_query(1), nullptr);
+
+    auto item = store.store_item(3);
+    ASSERT_TRUE(item);
+    EXPECT_FALSE(store.store_item(1));
+
+    auto stats = store.stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.retained, 1);
+}
+
+TEST(Store, RetentionUpsert) {
+    kstore::ShareStore<Model> store;
+    store.set_retention(2);
+    auto no_refs = [](int, kstore::StoreSlot) -> std::int64_t {
+        return 0;
+    };
+
+    // unreferenced upserts are retained and evicted like released entries
+    store.store_upsert_many(std::array { Model { 1 }, Model { 2 }, Model { 3 } }, no_refs);
+    EXPECT_EQ(store.size(), 2);
+    EXPECT_EQ(store.stats().retained, 2);
+    EXPECT_EQ(store.stats().evictions, 1);
+    EXPECT_EQ(store.store_query(1), nullptr);
+
+    // a retained entry updated without references goes back to the list
+    store.store_upsert_many(std::array { Model { 2, 20 } }, no_refs);
+    EXPECT_EQ(store.stats().hits, 1);
+    EXPECT_EQ(store.stats().retained, 2);
+    store.store_upsert_many(std::array { Model { 4 } }, no_refs);
+    EXPECT_EQ(store.size(), 2);
+    EXPECT_EQ(store.store_query(3), nullptr);
+    EXPECT_EQ(store.store_query(2)->age, 20);
+
+    store.set_retention(0);
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(Store, ScratchArena) {
+    struct Counting : std::pmr::memory_resource {
+        int   count { 0 };
+        void* do_allocate(std::size_t n, std::size_t align) override {
+            ++count;
+            return std::pmr::new_delete_resource()->allocate(n, align);
+        }
+        void do_deallocate(void* p, std::size_t n, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, n, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+            return this == &o;
+        }
+    } upstream;
+
+    kstore::detail::ScratchArena arena(&upstream);
+
+    auto fill = [&arena] {
+        auto                  scratch = arena.scope();
+        std::pmr::vector<int> v(1000, scratch.allocator());
+        std::pmr::unordered_map<int, int> m(scratch.allocator());
+        for (int i = 0; i < 100; i++) m[i] = i;
+    };
+
+    fill();
+    auto warm = upstream.count;
+    fill();
+    fill();
+    // the buffer grew to the high-water mark, later scopes stay off upstream
+    EXPECT_EQ(upstream.count, warm);
+}
+
+TEST(Store, TreeList) {
+    TreeListModel m;
+    std::vector<Model> items;
+    for (int i = 0; i < 100; i++) items.push_back(Model { i });
+    m.insert(0, items);
+    m.insert(50, Model { 100 });
+    EXPECT_EQ(m.at(50).uid, 100);
+    EXPECT_EQ(m.query_idx(51), 52);
+
+    m.move(0, 101, 1);
+    EXPECT_EQ(m.at(0).uid, 1);
+    EXPECT_EQ(m.query_idx(0), 100);
+
+    m.remove(10, 20);
+    EXPECT_EQ(m.size(), 81);
+    EXPECT_EQ(m.query_idx(15), std::nullopt);
+    EXPECT_EQ(m.at(10).uid, 31);
+    EXPECT_EQ(m.query_idx(100), 29);
+}
+
+TEST(Store, RowIndex) {
+    auto check = [](auto& m) {
+        for (std::size_t i = 0; i < m.size(); i++) {
+            EXPECT_EQ(m.query_idx(m.at(i).uid), i);
+        }
+    };
+
+    kstore::ShareStore<Model> store;
+    ListModel                 share;
+    MapListModel              vec;
+    share.set_store(&share, store);
+    for (int i = 0; i < 10; i++) {
+        share.insert(0, Model { i });
+        vec.insert(0, Model { i });
+    }
+    share.remove(2, 3);
+    vec.remove(2, 3);
+    share.insert(4, std::array { Model { 20 }, Model { 21 } });
+    vec.insert(4, std::array { Model { 20 }, Model { 21 } });
+    share.move(0, 5, 2);
+    vec.move(0, 5, 2);
+    check(share);
+    check(vec);
+
+    EXPECT_EQ(vec.query(20), &vec.at(*vec.query_idx(20)));
+    EXPECT_EQ(vec.query(5), nullptr);
+
+    // store updates land on the shifted row
+    int row = -1;
+    QObject::connect(&share, &QAbstractItemModel::dataChanged, [&row](const QModelIndex& idx) {
+        row = idx.row();
+    });
+    store.store_insert_range(std::array { Model { 21, 1 } });
+    EXPECT_EQ(row, share.query_idx(21));
+}
+
+TEST(Store, SyncMoves) {
+    MapListModel       m;
+    std::vector<Model> items;
+    for (int i = 0; i < 20; i++) items.push_back(Model { i });
+    m.insert(0, items);
+
+    int moves   = 0;
+    int layouts = 0;
+    QObject::connect(&m, &QAbstractItemModel::rowsMoved, [&moves] {
+        ++moves;
+    });
+    QObject::connect(&m, &QAbstractItemModel::layoutChanged, [&layouts] {
+        ++layouts;
+    });
+
+    // one item to the top is one move
+    std::rotate(items.begin(), items.end() - 1, items.end());
+    m.sync(items);
+    EXPECT_EQ(moves, 1);
+    EXPECT_EQ(layouts, 0);
+    EXPECT_EQ(m.at(0).uid, 19);
+    EXPECT_EQ(m.query_idx(18), 19);
+
+    // reversed is over the ratio
+    std::ranges::reverse(items);
+    m.sync(items);
+    EXPECT_EQ(moves, 1);
+    EXPECT_EQ(layouts, 1);
+    EXPECT_EQ(m.at(0).uid, 18);
+}
+
+TEST(Store, SyncChangedOnly) {
+    PersonMapListModel  m;
+    std::vector<Person> items;
+    for (int i = 0; i < 10; i++) items.push_back(Person { i });
+    m.insert(0, items);
+
+    std::vector<std::pair<int, int>> runs;
+    std::vector<QList<int>>          roles;
+    QObject::connect(
+        &m,
+        &QAbstractItemModel::dataChanged,
+        [&](const QModelIndex& first, const QModelIndex& last, const QList<int>& r) {
+            runs.emplace_back(first.row(), last.row());
+            roles.push_back(r);
+        });
+
+    items[3].age = 1;
+    items[4].age = 2;
+    m.sync(items);
+    EXPECT_EQ(runs, (std::vector<std::pair<int, int>> { { 3, 4 } }));
+    EXPECT_EQ(roles[0], QList<int> { m.roleOf("age") });
+
+    runs.clear();
+    m.sync(items);
+    m.replaceResetModel(items);
+    EXPECT_TRUE(runs.empty());
+}
+
+TEST(Store, SyncPlainMember) {
+    // age is not a property of Model, a change to it still lands and is signalled
+    MapListModel       m;
+    std::vector<Model> items;
+    for (int i = 0; i < 4; i++) items.push_back(Model { i });
+    m.insert(0, items);
+
+    int changed = 0;
+    QObject::connect(&m, &QAbstractItemModel::dataChanged, [&changed] {
+        ++changed;
+    });
+    items[1].age = 1;
+    m.sync(items);
+    EXPECT_EQ(m.at(1).age, 1);
+    items[2].age = 2;
+    m.replaceResetModel(items);
+    EXPECT_EQ(m.at(2).age, 2);
+    EXPECT_GT(changed, 0);
+
+    kstore::ShareStore<Model> store;
+    ListModel                 share;
+    share.set_store(&share, store);
+    share.insert(0, std::array { Model { 1 } });
+    auto results = store.store_insert_range(std::array { Model { 1, 5 } });
+    EXPECT_EQ(results[0], kstore::UpsertResult::Updated);
+    EXPECT_EQ(share.at(0).age, 5);
+}
+
+TEST(Store, BulkExtendRemove) {
+    MapListModel       m;
+    std::vector<Model> items;
+    for (int i = 0; i < 10; i++) items.push_back(Model { i });
+    m.insert(0, items);
+
+    int inserts = 0;
+    int removes = 0;
+    QObject::connect(&m, &QAbstractItemModel::rowsInserted, [&inserts] {
+        ++inserts;
+    });
+    QObject::connect(&m, &QAbstractItemModel::rowsRemoved, [&removes] {
+        ++removes;
+    });
+
+    EXPECT_EQ(m.extend(std::array { Model { 20 }, Model { 3 }, Model { 21 } }), 2);
+    EXPECT_EQ(inserts, 1);
+    EXPECT_EQ(m.at(10).uid, 20);
+    EXPECT_EQ(m.at(11).uid, 21);
+
+    // rows 0-4 and 10-11
+    m.remove_if([](const Model& el) {
+        return el.uid < 5 || el.uid >= 20;
+    });
+    EXPECT_EQ(removes, 2);
+    EXPECT_EQ(m.size(), 5);
+    EXPECT_EQ(m.at(0).uid, 5);
+}
+
+TEST(Store, Async) {
+    int              argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    MapListModel m;
+    m.set_async_budget(std::chrono::milliseconds(0));
+    std::vector<Model> items;
+    for (int i = 0; i < 1000; i++) items.push_back(Model { i });
+
+    // one chunk now, the rest on later turns
+    auto inserted = m.insert_async(0, items);
+    EXPECT_EQ(m.size(), MapListModel::async_chunk);
+    while (! inserted.isFinished()) QCoreApplication::processEvents();
+    EXPECT_EQ(m.size(), 1000);
+
+    // a later request cancels the in-flight one
+    auto reset  = m.reset_async(items);
+    auto synced = m.sync_async(std::vector { Model { 1 }, Model { 2000 }, Model { 0 } });
+    EXPECT_TRUE(reset.isCanceled());
+    while (! synced.isFinished()) QCoreApplication::processEvents();
+    EXPECT_EQ(m.size(), 3);
+    EXPECT_EQ(m.at(1).uid, 2000);
+}
+
+TEST(Store, Pager) {
+    MapListModel           m;
+    kstore::QMetaListPager pager;
+    pager.setPageSize(10);
+    pager.setPrefetchDistance(3);
+    pager.setModel(&m);
+
+    std::vector<std::array<qint32, 3>> reqs;
+    QObject::connect(&pager, &kstore::QMetaListPager::reqPage, [&](qint32 id, qint32 o, qint32 n) {
+        reqs.push_back({ id, o, n });
+    });
+    auto page = [](qint32 offset, qint32 n) {
+        std::vector<Model> out;
+        for (qint32 i = 0; i < n; i++) out.push_back(Model { offset + i });
+        return out;
+    };
+
+    // one page in flight however often the view reports
+    pager.setVisibleRange(0, 0);
+    pager.setVisibleRange(0, 0);
+    ASSERT_EQ(reqs.size(), 1);
+    EXPECT_TRUE(pager.pageLoaded(reqs[0][0], m, page(0, 10), true));
+    EXPECT_EQ(m.size(), 10);
+
+    // prefetched before the view reaches the end
+    pager.setVisibleRange(0, 5);
+    EXPECT_EQ(reqs.size(), 1);
+    pager.setVisibleRange(0, 6);
+    ASSERT_EQ(reqs.size(), 2);
+    EXPECT_EQ(reqs[1][1], 10);
+    pager.pageLoaded(reqs[1][0], m, page(10, 10), true);
+    EXPECT_EQ(pager.stats().hits, 1);
+    EXPECT_EQ(pager.stats().misses, 1);
+
+    // a canceled page is dropped when it arrives
+    pager.setVisibleRange(10, 17);
+    pager.cancel();
+    EXPECT_FALSE(pager.pageLoaded(reqs[2][0], m, page(20, 10), true));
+    EXPECT_EQ(pager.stats().stale, 1);
+    EXPECT_EQ(m.size(), 20);
+
+    pager.setVisibleRange(10, 18);
+    pager.pageLoaded(reqs[3][0], m, page(20, 10), false);
+    pager.setVisibleRange(20, 29);
+    EXPECT_EQ(reqs.size(), 4);
+    EXPECT_EQ(m.size(), 30);
+}
+
+TEST(Store, VirtualList) {
+    int              argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    VirtualListModel                                 m;
+    std::vector<std::pair<std::size_t, std::size_t>> reqs;
+    m.set_loader(&m, [&reqs](std::size_t offset, std::size_t count) {
+        reqs.emplace_back(offset, count);
+    });
+    m.set_block_size(100);
+    m.set_max_blocks(2);
+    m.set_placeholder(Model { -1 });
+    m.reset_virtual(1'000'050);
+    auto rows = [](std::size_t offset, std::size_t n) {
+        std::vector<Model> out;
+        for (std::size_t i = 0; i < n; i++) out.push_back(Model { int(offset + i) });
+        return out;
+    };
+
+    // placeholder until the block arrives, requested once from the event loop
+    EXPECT_EQ(m.size(), 1'000'050);
+    EXPECT_EQ(m.at(250).uid, -1);
+    EXPECT_EQ(m.at(299).uid, -1);
+    EXPECT_TRUE(reqs.empty());
+    QCoreApplication::processEvents();
+    ASSERT_EQ(reqs.size(), 1);
+    EXPECT_EQ(reqs[0], std::make_pair(200uz, 100uz));
+    EXPECT_EQ(m.fill(200, rows(200, 100)), 100);
+    EXPECT_EQ(m.at(250).uid, 250);
+    EXPECT_EQ(m.data(m.index(250), m.roleOf("uid")).toInt(), 250);
+
+    // short last block, and the cap evicts the least recently read
+    m.at(1'000'020);
+    QCoreApplication::processEvents();
+    EXPECT_EQ(reqs.back(), std::make_pair(1'000'000uz, 50uz));
+    m.fill(1'000'000, rows(1'000'000, 50));
+    m.at(0);
+    m.fill(0, rows(0, 100));
+    EXPECT_EQ(m.resident_blocks(), 2);
+    EXPECT_FALSE(m.loaded(200));
+    EXPECT_TRUE(m.loaded(1'000'049));
+
+    // rows shift on removal, dropped blocks are not asked for and their answers are ignored
+    m.at(700);
+    m.remove(0, 10);
+    QCoreApplication::processEvents();
+    EXPECT_EQ(reqs.size(), 2);
+    EXPECT_EQ(m.size(), 1'000'040);
+    EXPECT_EQ(m.fill(700, rows(700, 100)), 0);
+    EXPECT_FALSE(m.loaded(700));
+
+    // inserted rows stay in the blocks they complete
+    m.reset_virtual(150);
+    m.at(0);
+    m.fill(0, rows(0, 100));
+    m.insert(10, std::array { Model { 1000 }, Model { 1001 } });
+    EXPECT_EQ(m.size(), 152);
+    EXPECT_TRUE(m.loaded(0));
+    EXPECT_FALSE(m.loaded(100));
+    EXPECT_EQ(m.at(10).uid, 1000);
+    EXPECT_EQ(m.at(12).uid, 10);
+    EXPECT_EQ(m.at(99).uid, 97);
+}
+
+TEST(Store, Snapshot) {
+    using Snapshot = kstore::QStoreSnapshot<Person>;
+    QTemporaryDir dir;
+    auto          path = dir.filePath("store.snap");
+    {
+        kstore::ShareStore<Person> store;
+        PersonListModel            m;
+        m.set_store(&m, store);
+        m.insert(0, std::array { Person { 3, 30 }, Person { 1, 10 }, Person { 2, 20 } });
+        auto lists = std::array { Snapshot::list_of("main", m) };
+        ASSERT_TRUE(Snapshot::write(path, store, lists));
+    }
+
+    Snapshot snap;
+    ASSERT_TRUE(snap.open(path));
+    EXPECT_EQ(snap.size(), 3);
+    EXPECT_EQ(snap.query(2)->age, 20);
+    EXPECT_FALSE(snap.query(4));
+
+    // a list restores in its order, into a fresh store
+    kstore::ShareStore<Person> store;
+    PersonListModel            m;
+    m.set_store(&m, store);
+    m.resetModel(snap.items("main"));
+    ASSERT_EQ(m.size(), 3);
+    EXPECT_EQ(m.at(0).uid, 3);
+    EXPECT_EQ(m.at(2).age, 20);
+    EXPECT_TRUE(snap.items("other").empty());
+
+    // restore adds no reference, the store's own keeps each item
+    kstore::ShareStore<Person> loaded;
+    EXPECT_EQ(snap.restore(loaded), 3);
+    EXPECT_EQ(loaded.size(), 3);
+    EXPECT_EQ(loaded.store_query(3)->age, 30);
+
+    // with retention the restored items are retained, past the budget they are evicted
+    kstore::ShareStore<Person> retained;
+    retained.set_retention(2);
+    EXPECT_EQ(snap.restore(retained), 3);
+    EXPECT_EQ(retained.size(), 2);
+    EXPECT_EQ(retained.stats().retained, 2);
+    EXPECT_EQ(retained.stats().evictions, 1);
+
+    // another schema or a broken file is rejected
+    snap.close();
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+        file.seek(8);
+        QDataStream(&file) << ~Snapshot::schema();
+    }
+    EXPECT_FALSE(snap.open(path));
+    EXPECT_FALSE(snap.open(dir.filePath("missing.snap")));
+}
+
+TEST(Store, PmrShareList) {
+    std::pmr::monotonic_buffer_resource res;
+    kstore::pmr::ShareStore<PmrItem>    store(&res);
+    PmrListModel                        m(&res);
+    m.set_store(&m, store);
+    m.insert(0, std::array { PmrItem { 1, 10 }, PmrItem { 2, 20 } });
+    ASSERT_EQ(m.size(), 2);
+
+    // subscribed keys reach the list through the store
+    store.store_insert_range(std::array { PmrItem { 2, 21 } });
+    EXPECT_EQ(m.at(1).age, 21);
+    EXPECT_EQ(store.store_query(1)->age, 10);
+}
+
+TEST(Store, SnapshotSkipsUnstreamable) {
+    using Snapshot = kstore::QStoreSnapshot<NestedItem>;
+    auto props     = kstore::snapshot_properties(NestedItem::staticMetaObject);
+    ASSERT_EQ(props.size(), 2);
+    EXPECT_STREQ(props[1].name(), "age");
+
+    QTemporaryDir                  dir;
+    auto                           path = dir.filePath("nested.snap");
+    kstore::ShareStore<NestedItem> store;
+    store.store_insert(NestedItem { 1, Model { 7, 70 }, 30 });
+    store.store_insert(NestedItem { 2, Model { 8, 80 }, 40 });
+    ASSERT_TRUE(Snapshot::write(path, store));
+
+    // the properties after inner still round-trip
+    Snapshot snap;
+    ASSERT_TRUE(snap.open(path));
+    EXPECT_EQ(snap.query(1)->age, 30);
+    EXPECT_EQ(snap.query(2)->age, 40);
+    EXPECT_EQ(snap.query(2)->inner.uid, 0);
+}
+
+TEST(Store, Json) {
+    auto json = kstore::qvariant_to_josn(QVariant::fromValue(Person { 7, 30 }));
+    EXPECT_EQ(json.toObject().value("uid").toInt(), 7);
+    EXPECT_EQ(json.toObject().value("age").toInt(), 30);
+    EXPECT_EQ(kstore::qvariant_from_josn<Person>(json)->age, 30);
+
+    // values of another json type still convert
+    auto obj = QJsonObject { { "uid", 8 }, { "age", "12" } };
+    auto out = kstore::qvariant_from_josn<Person>(obj);
+    ASSERT_TRUE(out);
+    EXPECT_EQ(out->uid, 8);
+    EXPECT_EQ(out->age, 12);
+}
+
+TEST(Store, JsonStream) {
+    PersonMapListModel               m;
+    std::vector<std::size_t>         batches;
+    kstore::QJsonArrayIngest<Person> ingest(2, [&m, &batches](std::vector<Person>& batch) {
+        batches.push_back(batch.size());
+        kstore::json_model_sink(m)(batch);
+    });
+
+    // chunks split inside strings and elements
+    std::string json = R"([{"uid": 1, "age": 20}, {"uid": 2, "name": "a,]}\"["},)"
+                       R"( "skip", {"uid": 3}, {"uid": 4, "age": 40}, {"uid": 5}])";
+    for (std::size_t i = 0; i < json.size(); i += 5) {
+        auto n = std::min<std::size_t>(5, json.size() - i);
+        ASSERT_TRUE(ingest.feed(QByteArrayView(json).sliced(i, n)));
+    }
+    EXPECT_EQ(m.size(), 4);
+    EXPECT_TRUE(ingest.finish());
+    EXPECT_EQ(m.size(), 5);
+    EXPECT_EQ(m.at(3).age, 40);
+    EXPECT_EQ(ingest.skipped(), 1);
+    EXPECT_EQ(batches, (std::vector<std::size_t> { 2, 2, 1 }));
+
+    // the store sink adds no reference, retention keeps only the newest batch items
+    kstore::ShareStore<Person> store;
+    store.set_retention(3);
+    kstore::QJsonArrayIngest<Person> loading(2, kstore::json_store_sink(store));
+    ASSERT_TRUE(loading.feed(json));
+    EXPECT_TRUE(loading.finish());
+    EXPECT_EQ(store.size(), 3);
+    EXPECT_EQ(store.stats().evictions, 2);
+    EXPECT_EQ(store.store_query(4)->age, 40);
+    EXPECT_EQ(store.store_query(1), nullptr);
+
+    kstore::QJsonArrayIngest<Person> broken(2, kstore::json_model_sink(m));
+    EXPECT_FALSE(broken.feed(R"({"uid": 1})"));
+    EXPECT_FALSE(broken.finish());
+}
+
 #include "store.moc"
\ No newline at end of file